@@ -4,34 +4,67 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../source/dma.c \
+../source/event.c \
 ../source/fsm_trafficlight.c \
+../source/idle.c \
+../source/latency.c \
 ../source/led.c \
+../source/lptmr.c \
 ../source/main.c \
 ../source/mtb.c \
+../source/profile.c \
+../source/recorder.c \
 ../source/semihost_hardfault.c \
+../source/swtimer.c \
 ../source/systick.c \
+../source/task.c \
 ../source/touch.c \
-../source/tpm.c 
+../source/touch_filter.c \
+../source/tpm.c \
+../source/trace.c 
 
 C_DEPS += \
+./source/dma.d \
+./source/event.d \
 ./source/fsm_trafficlight.d \
+./source/idle.d \
+./source/latency.d \
 ./source/led.d \
+./source/lptmr.d \
 ./source/main.d \
 ./source/mtb.d \
+./source/profile.d \
+./source/recorder.d \
 ./source/semihost_hardfault.d \
+./source/swtimer.d \
 ./source/systick.d \
+./source/task.d \
 ./source/touch.d \
-./source/tpm.d 
+./source/touch_filter.d \
+./source/tpm.d \
+./source/trace.d 
 
 OBJS += \
+./source/dma.o \
+./source/event.o \
 ./source/fsm_trafficlight.o \
+./source/idle.o \
+./source/latency.o \
 ./source/led.o \
+./source/lptmr.o \
 ./source/main.o \
 ./source/mtb.o \
+./source/profile.o \
+./source/recorder.o \
 ./source/semihost_hardfault.o \
+./source/swtimer.o \
 ./source/systick.o \
+./source/task.o \
 ./source/touch.o \
-./source/tpm.o 
+./source/touch_filter.o \
+./source/tpm.o \
+./source/trace.o 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -46,7 +79,7 @@ source/%.o: ../source/%.c source/subdir.mk
 clean: clean-source
 
 clean-source:
-	-$(RM) ./source/fsm_trafficlight.d ./source/fsm_trafficlight.o ./source/led.d ./source/led.o ./source/main.d ./source/main.o ./source/mtb.d ./source/mtb.o ./source/semihost_hardfault.d ./source/semihost_hardfault.o ./source/systick.d ./source/systick.o ./source/touch.d ./source/touch.o ./source/tpm.d ./source/tpm.o
+	-$(RM) ./source/dma.d ./source/dma.o ./source/event.d ./source/event.o ./source/fsm_trafficlight.d ./source/fsm_trafficlight.o ./source/idle.d ./source/idle.o ./source/latency.d ./source/latency.o ./source/led.d ./source/led.o ./source/lptmr.d ./source/lptmr.o ./source/main.d ./source/main.o ./source/mtb.d ./source/mtb.o ./source/profile.d ./source/profile.o ./source/recorder.d ./source/recorder.o ./source/semihost_hardfault.d ./source/semihost_hardfault.o ./source/swtimer.d ./source/swtimer.o ./source/systick.d ./source/systick.o ./source/task.d ./source/task.o ./source/touch.d ./source/touch.o ./source/touch_filter.d ./source/touch_filter.o ./source/tpm.d ./source/tpm.o ./source/trace.d ./source/trace.o
 
 .PHONY: clean-source
 
@@ -49,8 +49,10 @@ void BOARD_InitDebugConsole(void)
      *  01: IRC48M
      *  10: OSCERCLK
      *  11: MCGIRCCLK
+     * OSCERCLK keeps the same frequency in RUN and VLPR, so the baud rate divisors
+     * computed here from BOARD_DEBUG_UART_CLK_FREQ hold in both.
      */
-    CLOCK_SetLpsci0Clock(1);
+    CLOCK_SetLpsci0Clock(2);
 
     uartClkSrcFreq = BOARD_DEBUG_UART_CLK_FREQ;
     DbgConsole_Init(BOARD_DEBUG_UART_BASEADDR, BOARD_DEBUG_UART_BAUDRATE, BOARD_DEBUG_UART_TYPE, uartClkSrcFreq);
@@ -44,8 +44,8 @@
 /* The LPSCI to use for debug messages. */
 #define BOARD_DEBUG_UART_TYPE DEBUG_CONSOLE_DEVICE_TYPE_LPSCI
 #define BOARD_DEBUG_UART_BASEADDR (uint32_t) UART0
-#define BOARD_DEBUG_UART_CLKSRC kCLOCK_PllFllSelClk
-#define BOARD_DEBUG_UART_CLK_FREQ CLOCK_GetPllFllSelClkFreq()
+#define BOARD_DEBUG_UART_CLKSRC kCLOCK_Osc0ErClk
+#define BOARD_DEBUG_UART_CLK_FREQ CLOCK_GetOsc0ErClkFreq()
 #define BOARD_UART_IRQ UART0_IRQn
 #define BOARD_UART_IRQ_HANDLER UART0_IRQHandler
 
@@ -306,3 +306,47 @@ void BOARD_BootClockVLPR(void)
     SystemCoreClock = BOARD_BOOTCLOCKVLPR_CORE_CLOCK;
 }
 
+
+/*******************************************************************************
+ ******************* Runtime switch between RUN and VLPR ***********************
+ ******************************************************************************/
+void BOARD_RunClockVLPR(void)
+{
+    /* Set MCG to PBE mode: the crystal drives MCGOUTCLK while the PLL stays locked. */
+    MCG->C1 = (MCG->C1 & ~MCG_C1_CLKS_MASK) | MCG_C1_CLKS(kMCG_ClkOutSrcExternal);
+    while ((MCG->S & MCG_S_CLKST_MASK) != MCG_S_CLKST(kMCG_ClkOutSrcExternal))
+    {
+    }
+    /* Set the system clock dividers in SIM to the VLPR limits. */
+    CLOCK_SetOutDiv(BOARD_RUNCLOCKVLPR_OUTDIV1, BOARD_RUNCLOCKVLPR_OUTDIV4);
+    /* Set MCG to BLPE mode, which turns the PLL off. */
+    CLOCK_SetBlpeMode();
+    /* Set VLPR power mode. */
+#if (defined(FSL_FEATURE_SMC_HAS_LPWUI) && FSL_FEATURE_SMC_HAS_LPWUI)
+    SMC_SetPowerModeVlpr(SMC, false);
+#else
+    SMC_SetPowerModeVlpr(SMC);
+#endif
+    while (SMC_GetPowerModeState(SMC) != kSMC_PowerStateVlpr)
+    {
+    }
+    /* Set SystemCoreClock variable. */
+    SystemCoreClock = BOARD_RUNCLOCKVLPR_CORE_CLOCK;
+}
+
+void BOARD_RunClockRUN(void)
+{
+    /* Set RUN power mode. The MCG mode can't change in VLPR. */
+    SMC_SetPowerModeRun(SMC);
+    while (SMC_GetPowerModeState(SMC) != kSMC_PowerStateRun)
+    {
+    }
+    /* Set MCG to PBE mode, waiting for the PLL to lock. */
+    CLOCK_SetPbeMode(kMCG_PllClkSelPll0, &mcgConfig_BOARD_BootClockRUN.pll0Config);
+    /* Set the clock configuration in SIM module before the PLL drives the core again. */
+    CLOCK_SetSimConfig(&simConfig_BOARD_BootClockRUN);
+    /* Set MCG to PEE mode. */
+    CLOCK_SetPeeMode();
+    /* Set SystemCoreClock variable. */
+    SystemCoreClock = BOARD_BOOTCLOCKRUN_CORE_CLOCK;
+}
@@ -127,5 +127,41 @@ void BOARD_BootClockVLPR(void);
 }
 #endif /* __cplusplus*/
 
+/*******************************************************************************
+ ******************* Runtime switch between RUN and VLPR ***********************
+ ******************************************************************************/
+/*******************************************************************************
+ * Definitions for BOARD_RunClockVLPR configuration
+ ******************************************************************************/
+#define BOARD_RUNCLOCKVLPR_CORE_CLOCK               4000000U  /*!< Core clock frequency: 4000000Hz */
+#define BOARD_RUNCLOCKVLPR_OUTDIV1                       0x1U  /*!< SIM_CLKDIV1 - OUTDIV1: /2 of the 8 MHz crystal */
+#define BOARD_RUNCLOCKVLPR_OUTDIV4                       0x4U  /*!< SIM_CLKDIV1 - OUTDIV4: /5, bus and flash 800 kHz */
+
+/*******************************************************************************
+ * API for runtime switching between BOARD_BootClockRUN and BOARD_RunClockVLPR
+ ******************************************************************************/
+#if defined(__cplusplus)
+extern "C" {
+#endif /* __cplusplus*/
+
+/*!
+ * @brief Switches from BOARD_BootClockRUN (PEE) to VLPR at runtime.
+ *
+ * Unlike BOARD_BootClockVLPR, the MCG goes to BLPE rather than BLPI, so the core runs from the
+ * crystal and OSCERCLK keeps running for the modules clocked from it (TPM, LPTMR, LPSCI).
+ */
+void BOARD_RunClockVLPR(void);
+
+/*!
+ * @brief Switches from BOARD_RunClockVLPR back to BOARD_BootClockRUN (PEE) at runtime.
+ *
+ * Waits for the PLL to lock, which takes up to about 1 ms.
+ */
+void BOARD_RunClockRUN(void);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus*/
+
 #endif /* _CLOCK_CONFIG_H_ */
 
@@ -0,0 +1,101 @@
+/**
+ * \file    dma.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Function definitions for DMA (Direct Memory Access) of LED fade waveforms
+ */
+
+#include "board.h"
+
+/**
+ * User-defined libraries
+ */
+#include "dma.h"
+#include "tpm.h"
+
+/**
+ * \fn		void load_dma_channel
+ * \param	uint8_t channel The DMA channel to load
+ * \param	const uint16_t *source First entry of the waveform
+ * \param	volatile uint32_t *destination The CnV register to copy the waveform into
+ * \param	uint32_t steps Number of entries in the waveform
+ * \param	uint32_t link DCR bits that request and link this channel
+ * \return	N/A
+ * \brief   Load one channel to copy one 16-bit entry per request (cycle-steal) from an
+ * 			incrementing source to a fixed destination
+ */
+static void load_dma_channel(uint8_t channel, const uint16_t *source, volatile uint32_t *destination, uint32_t steps, uint32_t link)
+{
+	/**
+     * Clear DONE (write 1 to clear) so the channel can be loaded again
+     */
+	DMA0->DMA[channel].DSR_BCR = DMA_DSR_BCR_DONE_MASK;
+
+	DMA0->DMA[channel].SAR = (uint32_t)source;
+	DMA0->DMA[channel].DAR = (uint32_t)destination;
+	DMA0->DMA[channel].DSR_BCR = DMA_DSR_BCR_BCR(steps * sizeof(uint16_t));
+
+	/**
+     * Configure the DMA DCR register:
+     * 	- Increment the source but not the destination, 16 bits at a time
+     * 	- One transfer per request
+     * 	- Stop requesting once BCR reaches 0
+     */
+	DMA0->DMA[channel].DCR =
+		DMA_DCR_SINC_MASK |
+		DMA_DCR_SSIZE(DMA_SIZE_16BIT) |
+		DMA_DCR_DSIZE(DMA_SIZE_16BIT) |
+		DMA_DCR_CS_MASK |
+		DMA_DCR_D_REQ_MASK |
+		link;
+}
+
+void init_onboard_dma(void)
+{
+	/**
+	 * Enable clock to DMA and DMAMUX
+	 */
+	SIM->SCGC6 |= SIM_SCGC6_DMAMUX_MASK;
+	SIM->SCGC7 |= SIM_SCGC7_DMA_MASK;
+
+	/**
+     * Route the TPM2 overflow to the red channel only. Green and blue are started by links so all
+     * three CnV writes follow the same overflow back to back
+     */
+	DMAMUX0->CHCFG[RED_LED_DMA_CHANNEL] = 0;
+	DMAMUX0->CHCFG[RED_LED_DMA_CHANNEL] =
+		DMAMUX_CHCFG_SOURCE(DMAMUX_SOURCE_TPM2_OVERFLOW) |
+		DMAMUX_CHCFG_ENBL_MASK;
+}
+
+void start_dma_fade(const uint16_t *red_counts, const uint16_t *green_counts, const uint16_t *blue_counts, uint32_t steps)
+{
+	load_dma_channel(BLUE_LED_DMA_CHANNEL, blue_counts, &TPM0->CONTROLS[BLUE_LED_TPM0_CHANNEL].CnV, steps, 0);
+	load_dma_channel(GREEN_LED_DMA_CHANNEL, green_counts, &TPM2->CONTROLS[GREEN_LED_TPM2_CHANNEL].CnV, steps,
+		DMA_DCR_LINKCC(DMA_LINKCC_EACH_TRANSFER) |
+		DMA_DCR_LCH1(BLUE_LED_DMA_CHANNEL));
+	load_dma_channel(RED_LED_DMA_CHANNEL, red_counts, &TPM2->CONTROLS[RED_LED_TPM2_CHANNEL].CnV, steps,
+		DMA_DCR_ERQ_MASK |
+		DMA_DCR_LINKCC(DMA_LINKCC_EACH_TRANSFER) |
+		DMA_DCR_LCH1(GREEN_LED_DMA_CHANNEL));
+
+	/**
+     * Let TPM2 overflows request DMA. Writing SC back also clears a stale overflow flag (write 1 to
+     * clear), so the first entry is copied at the next reload
+     */
+	TPM2->SC |= TPM_SC_DMA_MASK;
+}
+
+uint32_t stop_dma_fade(void)
+{
+	DMA0->DMA[RED_LED_DMA_CHANNEL].DCR &= ~DMA_DCR_ERQ_MASK;
+	TPM2->SC &= ~TPM_SC_DMA_MASK;
+
+	return ((DMA0->DMA[RED_LED_DMA_CHANNEL].DSR_BCR & DMA_DSR_BCR_BCR_MASK) / sizeof(uint16_t));
+}
+
+bool dma_fade_running(void)
+{
+	return (((DMA0->DMA[RED_LED_DMA_CHANNEL].DCR & DMA_DCR_ERQ_MASK) != 0) ||
+		((DMA0->DMA[BLUE_LED_DMA_CHANNEL].DSR_BCR & DMA_DSR_BCR_BSY_MASK) != 0));
+}
@@ -0,0 +1,102 @@
+/**
+ * \file    dma.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Macros and function headers for DMA (Direct Memory Access) of LED fade waveforms
+ */
+
+#ifndef DMA_H_
+#define DMA_H_
+
+/**
+ * \def		RED_LED_DMA_CHANNEL
+ * \brief	DMA channel that copies the red waveform into TPM2 channel 0. Requested by the TPM2
+ * 			overflow, and links to GREEN_LED_DMA_CHANNEL after each transfer
+ */
+#define RED_LED_DMA_CHANNEL\
+	(0)
+
+/**
+ * \def		GREEN_LED_DMA_CHANNEL
+ * \brief	DMA channel that copies the green waveform into TPM2 channel 1. Only started by the
+ * 			link from RED_LED_DMA_CHANNEL, and links to BLUE_LED_DMA_CHANNEL after each transfer
+ */
+#define GREEN_LED_DMA_CHANNEL\
+	(1)
+
+/**
+ * \def		BLUE_LED_DMA_CHANNEL
+ * \brief	DMA channel that copies the blue waveform into TPM0 channel 1. Only started by the
+ * 			link from GREEN_LED_DMA_CHANNEL
+ */
+#define BLUE_LED_DMA_CHANNEL\
+	(2)
+
+/**
+ * \def		DMAMUX_SOURCE_TPM2_OVERFLOW
+ * \brief	DMAMUX request source number of the TPM2 overflow
+ */
+#define DMAMUX_SOURCE_TPM2_OVERFLOW\
+	(56)
+
+/**
+ * \def		DMA_SIZE_16BIT
+ * \brief	Configuration for DCR SSIZE and DSIZE
+ * \detail
+ * 		0: 32-bit
+ * 		1: 8-bit
+ * 		2: 16-bit
+ */
+#define DMA_SIZE_16BIT\
+	(2)
+
+/**
+ * \def		DMA_LINKCC_EACH_TRANSFER
+ * \brief	Configuration for DCR LINKCC
+ * \detail
+ * 		0: No channel-to-channel linking
+ * 		1: Link to LCH1 after each cycle-steal transfer, then to LCH2 after BCR reaches 0
+ * 		2: Link to LCH1 after each cycle-steal transfer
+ * 		3: Link to LCH1 after BCR reaches 0
+ */
+#define DMA_LINKCC_EACH_TRANSFER\
+	(2)
+
+/**
+ * \fn		void init_onboard_dma
+ * \param	N/A
+ * \return	N/A
+ * \brief   Clock the DMA and DMAMUX and route the TPM2 overflow request to RED_LED_DMA_CHANNEL
+ */
+void init_onboard_dma(void);
+
+/**
+ * \fn		void start_dma_fade
+ * \param	const uint16_t *red_counts Red TPM count for each PWM period of the fade
+ * \param	const uint16_t *green_counts Green TPM count for each PWM period of the fade
+ * \param	const uint16_t *blue_counts Blue TPM count for each PWM period of the fade
+ * \param	uint32_t steps Number of entries in each of the three waveforms
+ * \return	N/A
+ * \brief   Copy one entry of each waveform into the LED CnV registers on every TPM2 overflow,
+ * 			without any interrupt, until all of them have been copied
+ */
+void start_dma_fade(const uint16_t *red_counts, const uint16_t *green_counts, const uint16_t *blue_counts, uint32_t steps);
+
+/**
+ * \fn		uint32_t stop_dma_fade
+ * \param	N/A
+ * \return	Number of waveform entries that had not been copied yet
+ * \brief   Stop the fade started by start_dma_fade(), if it is still running
+ */
+uint32_t stop_dma_fade(void);
+
+/**
+ * \fn		bool dma_fade_running
+ * \param	N/A
+ * \return	Returns true until the fade started by start_dma_fade() has copied its last entry
+ * \brief   The red channel stops requesting once its BCR reaches 0, and the linked channels
+ * 			finish straight after it
+ */
+bool dma_fade_running(void);
+
+#endif /* DMA_H_ */
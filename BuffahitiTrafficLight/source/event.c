@@ -0,0 +1,146 @@
+/**
+ * \file    event.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Function definitions for the lock-free queue of events from interrupts to the main loop
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+#include "fsl_debug_console.h"
+
+/**
+ * User-defined libraries
+ */
+#include "event.h"
+#include "systick.h"
+#include "touch.h"
+
+#if (EVENT_DEPTH & (EVENT_DEPTH - 1)) != 0 || EVENT_DEPTH > 128
+#error "EVENT_DEPTH must be a power of 2 no larger than 128"
+#endif
+
+#if TOUCH_IRQ_PRIORITY != EVENT_IRQ_PRIORITY
+#error "TSI0_IRQHandler() publishes events, so it must run at EVENT_IRQ_PRIORITY"
+#endif
+
+/**
+ * \var		event_t event_ring[EVENT_DEPTH]
+ * \brief	Queued events. A slot is only written by the producer while it is free and only read
+ * 			by the consumer while it is queued, so neither side ever touches the other's
+ */
+static event_t event_ring[EVENT_DEPTH];
+
+/**
+ * \var		volatile uint8_t event_head
+ * \brief	Count of events published, modulo 256. Only written by event_publish()
+ */
+static volatile uint8_t event_head;
+
+/**
+ * \var		volatile uint8_t event_tail
+ * \brief	Count of events taken, modulo 256. Only written by event_take()
+ */
+static volatile uint8_t event_tail;
+
+/**
+ * \var		uint8_t event_peak
+ * \brief	Most events queued at once since the last report
+ */
+static uint8_t event_peak;
+
+/**
+ * \var		uint32_t event_dropped[NUM_EVENT_KINDS]
+ * \brief	Events of each kind dropped because the queue was full, since the last report
+ */
+static uint32_t event_dropped[NUM_EVENT_KINDS];
+
+bool event_publish(event_kind_t kind, uint32_t arg)
+{
+	bool return_value = false;
+	uint8_t head = event_head;
+	uint8_t queued = (uint8_t)(head - event_tail);
+	event_t *event;
+
+	if(queued < EVENT_DEPTH){
+		event = &event_ring[head % EVENT_DEPTH];
+		event->arg = arg;
+		event->stamp = systick_counts();
+		event->kind = kind;
+
+	    /**
+	     * Fill the slot before publishing it, so the consumer never sees a half-written event
+	     */
+		__DMB();
+		event_head = head + 1;
+
+		queued++;
+
+		if(queued > event_peak){
+			event_peak = queued;
+		}
+
+		return_value = true;
+	}
+	else{
+		event_dropped[kind]++;
+	}
+
+	return (return_value);
+}
+
+bool event_take(event_t *event)
+{
+	bool return_value = false;
+	uint8_t tail = event_tail;
+
+	if(tail != event_head){
+		*event = event_ring[tail % EVENT_DEPTH];
+
+	    /**
+	     * Copy the slot out before freeing it, so the producer never overwrites it mid-copy
+	     */
+		__DMB();
+		event_tail = tail + 1;
+
+		return_value = true;
+	}
+
+	return (return_value);
+}
+
+bool event_pending(void)
+{
+	return (event_tail != event_head);
+}
+
+void event_report(void)
+{
+	uint32_t dropped[NUM_EVENT_KINDS];
+	uint8_t peak;
+	uint8_t kind;
+
+    /**
+     * The counters belong to the producer, so they are read and reset with it masked
+     */
+	__disable_irq();
+
+	peak = event_peak;
+	event_peak = 0;
+
+	for(kind = 0; kind < NUM_EVENT_KINDS; kind++){
+		dropped[kind] = event_dropped[kind];
+		event_dropped[kind] = 0;
+	}
+
+	__enable_irq();
+
+	PRINTF("events,%u,%u,%u,%u,%u,%u\r\n",
+		(uint8_t)(event_head - event_tail),
+		peak,
+		dropped[EVENT_TICK],
+		dropped[EVENT_TOUCH],
+		dropped[EVENT_CONSOLE],
+		dropped[EVENT_COMMAND]);
+}
@@ -0,0 +1,109 @@
+/**
+ * \file    event.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Macros and function headers for the lock-free queue of events from interrupts to the
+ * 			main loop
+ */
+
+#ifndef EVENT_H_
+#define EVENT_H_
+
+/**
+ * \def		EVENT_DEPTH
+ * \brief	Number of events that can be queued before new ones are dropped (a power of 2, at most
+ * 			128 so the free-running indices can't pass each other)
+ */
+#define EVENT_DEPTH\
+	(32)
+
+/**
+ * \def		EVENT_IRQ_PRIORITY
+ * \brief	The one interrupt priority every publisher runs at (range 0 to 3, with 0 being highest
+ * 			priority). Interrupts at the same priority never preempt each other, so together they
+ * 			are a single producer and the queue needs no lock
+ */
+#define EVENT_IRQ_PRIORITY\
+	(3)
+
+/**
+ * \def		EVENT_REPORT_CMD
+ * \brief	Character that requests event_report() when received on the debug console
+ */
+#define EVENT_REPORT_CMD\
+	('e')
+
+/**
+ * \typedef	event_kind_t
+ * \brief	To allow objects of enum event_kind_e to be declared with ease
+ */
+typedef enum event_kind_e event_kind_t;
+
+/**
+ * \enum	event_kind_e
+ * \brief	What an event reports. The meaning of its arg depends on this
+ */
+enum event_kind_e {
+	EVENT_TICK,			/* arg: ticks raised since boot, which the main loop catches up to */
+	EVENT_TOUCH,		/* arg: raw value of the scan that finished */
+	EVENT_CONSOLE,		/* arg: unused, a start bit arrived on the console */
+	EVENT_COMMAND,		/* arg: character received on the console */
+	NUM_EVENT_KINDS
+};
+
+/**
+ * \typedef	event_t
+ * \brief	To allow objects of struct event_s to be declared with ease
+ */
+typedef struct event_s event_t;
+
+/**
+ * \struct	event_s
+ * \brief	One queued event. stamp is systick_counts() when it was published
+ */
+struct event_s {
+	uint32_t arg;
+	uint32_t stamp;
+	uint8_t kind;
+};
+
+/**
+ * \fn		bool event_publish
+ * \param	event_kind_t kind The kind of event
+ * \param	uint32_t arg Its argument, see event_kind_e
+ * \return	Returns true if the event was queued, false if the queue was full and it was counted
+ * 			as dropped instead
+ * \brief   Queue an event for the main loop. Call from an interrupt at EVENT_IRQ_PRIORITY, or
+ * 			with interrupts masked. O(1), never waits
+ */
+bool event_publish(event_kind_t kind, uint32_t arg);
+
+/**
+ * \fn		bool event_take
+ * \param	event_t *event Receives the oldest queued event
+ * \return	Returns true if there was an event, false if event was not written
+ * \brief   Take the oldest queued event. Main loop only
+ */
+bool event_take(event_t *event);
+
+/**
+ * \fn		bool event_pending
+ * \param	N/A
+ * \return	Returns true if event_take() has an event to take
+ * \brief   Lets the main loop decide whether it can sleep. Call with interrupts masked for the
+ * 			answer to still hold when it sleeps
+ */
+bool event_pending(void);
+
+/**
+ * \fn		void event_report
+ * \param	N/A
+ * \return	N/A
+ * \brief   Print the queue's depth now and at its deepest, and the events dropped of each kind
+ * 			since the last report, over the debug console:
+ * 			events,<queued>,<peak>,<tick dropped>,<touch dropped>,<console dropped>,<command dropped>
+ * 			A dropped tick is not lost, since the next EVENT_TICK carries the count it was behind
+ */
+void event_report(void);
+
+#endif /* EVENT_H_ */
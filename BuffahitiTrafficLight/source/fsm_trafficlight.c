@@ -14,101 +14,154 @@
  */
 #include "fsm_trafficlight.h"
 #include "led.h"
+#include "profile.h"
+#include "swtimer.h"
 #include "systick.h"
+#include "trace.h"
 
 /**
- * \var		volatile bool button_pressed
- * \brief	Flag controlled by physically touching the on-board touch sensor
+ * \var		const mode_desc_t mode_table[NUM_MODES]
+ * \brief	Next mode, RGB levels, dwell time and name of every mode. Indexed by mode_t and
+ * 			kept const so it is placed in flash rather than RAM
  */
-volatile bool button_pressed = false;
+const mode_desc_t mode_table[NUM_MODES] = {
+	[STOP] = {
+		.next_mode = GO,
+		.red_level = STOP_RED_LEVEL,
+		.green_level = STOP_GREEN_LEVEL,
+		.blue_level = STOP_BLUE_LEVEL,
+		.dwell_ticks = SEC_TO_TICKS(SEC_PER_STOP),
+		.name = "STOP"
+	},
+	[GO] = {
+		.next_mode = WARNING,
+		.red_level = GO_RED_LEVEL,
+		.green_level = GO_GREEN_LEVEL,
+		.blue_level = GO_BLUE_LEVEL,
+		.dwell_ticks = SEC_TO_TICKS(SEC_PER_GO),
+		.name = "GO"
+	},
+	[WARNING] = {
+		.next_mode = STOP,
+		.red_level = WARNING_RED_LEVEL,
+		.green_level = WARNING_GREEN_LEVEL,
+		.blue_level = WARNING_BLUE_LEVEL,
+		.dwell_ticks = SEC_TO_TICKS(SEC_PER_WARNING),
+		.name = "WARNING"
+	},
+	[CROSSWALK] = {
+		.next_mode = GO,
+		.red_level = CROSSWALK_RED_LEVEL,
+		.green_level = CROSSWALK_GREEN_LEVEL,
+		.blue_level = CROSSWALK_BLUE_LEVEL,
+		.dwell_ticks = SEC_TO_TICKS(SEC_PER_CROSSWALK),
+		.name = "CROSSWALK"
+	}
+};
 
 /**
- * \var		volatile bool transitioning
- * \brief	Flag to indicate whether LEDs are actively transitioning or not
+ * \fn		void state_timer_expired
+ * \param	void *arg The traffic light whose state timer expired
+ * \return	N/A
+ * \brief   End of the fade or of the stable period
  */
-volatile bool transitioning = false;
+static void state_timer_expired(void *arg)
+{
+	trafficlight_t *tl = arg;
 
-/**
- * \var		volatile bool crosswalk_on
- * \brief	Flag to indicate whether LED is actively on during CROSSWALK mode (since it should blink)
- */
-volatile bool crosswalk_on = false;
+    /**
+     * If we have been transitioning to the current state for enough time, start the stable
+     * period (and the first blink if this is CROSSWALK). Otherwise we have been stable for enough
+     * time, so begin transitioning
+     */
+	if(tl->transitioning){
+		begin_stable(tl);
 
-/**
- * \var		state_t current
- * \brief	The current state of the traffic light
- */
-volatile state_t current;
+		TRACE_EVENT(TRACE_STABLE, tl->current.mode, 0);
+	}
+	else{
+		begin_transition(tl);
+	}
+}
 
 /**
- * \var		state_t next
- * \brief	The next state of the traffic light
+ * \fn		void step_timer_expired
+ * \param	void *arg The traffic light whose step timer expired
+ * \return	N/A
+ * \brief   Next fade step, or CROSSWALK blink toggle
  */
-volatile state_t next;
+static void step_timer_expired(void *arg)
+{
+	trafficlight_t *tl = arg;
+	uint32_t stamp;
 
-/**
- * \var		extern volatile ticktime_t ticks_spent_transitioning
- * \brief	Defined in systick.c
- */
-extern volatile ticktime_t ticks_spent_transitioning;
+	if(tl->transitioning){
+		PROFILE_BEGIN(stamp);
+		step_leds(tl);
+		PROFILE_END(PROBE_STEP_LEDS, stamp);
+		tl->output(tl, true);
 
-/**
- * \var		extern volatile ticktime_t ticks_spent_stable
- * \brief	Defined in systick.c
- */
-extern volatile ticktime_t ticks_spent_stable;
+		if(tl->fade.steps_left > 0){
+			start_swtimer(tl->timers, &tl->step_timer, ticks_since_startup + 1);
+		}
+	}
 
-/**
- * \var		extern volatile uint8_t red_level_end
- * \brief	Defined in led.c
- */
-extern volatile uint8_t red_level_end;
+    /**
+     * The end of the stable period wins over a blink toggle due on the same tick, so the blink is
+     * left alone for state_timer_expired() to replace
+     */
+	else if(tl->current.mode == CROSSWALK && !swtimer_due(tl->timers, &tl->state_timer)){
+
+		/**
+		 * If we have kept the LED on for enough time this blink, turn off LEDs. Otherwise we have
+		 * kept it off for enough time, so turn on LEDs
+		 */
+		if(tl->crosswalk_on){
+			tl->crosswalk_on = false;
+			tl->output(tl, false);
+			start_swtimer(tl->timers, &tl->step_timer, ticks_since_startup + TICKS_PER_CROSSWALK_OFF);
+		}
+		else{
+			tl->crosswalk_on = true;
+			tl->output(tl, true);
+			start_swtimer(tl->timers, &tl->step_timer, ticks_since_startup + TICKS_PER_CROSSWALK_ON);
+		}
+	}
+}
 
-/**
- * \var		volatile uint8_t green_level_end
- * \brief	Defined in led.c
- */
-extern volatile uint8_t green_level_end;
+void init_fsm_trafficlight(trafficlight_t *tl, swtimer_wheel_t *timers, touch_input_t input, void *input_context, led_output_t output)
+{
+	tl->current.mode = STOP;
+	tl->current.red_level = mode_table[STOP].red_level;
+	tl->current.green_level = mode_table[STOP].green_level;
+	tl->current.blue_level = mode_table[STOP].blue_level;
 
-/**
- * \var		volatile uint8_t blue_level_end
- * \brief	Defined in led.c
- */
-extern volatile uint8_t blue_level_end;
+	tl->red_level_end = tl->current.red_level;
+	tl->green_level_end = tl->current.green_level;
+	tl->blue_level_end = tl->current.blue_level;
 
-void init_fsm_trafficlight(void)
-{
-	current.mode = STOP;
-	current.red_level = STOP_RED_LEVEL;
-	current.green_level = STOP_GREEN_LEVEL;
-	current.blue_level = STOP_BLUE_LEVEL;
-
-	next.mode = GO;
-	next.red_level = GO_RED_LEVEL;
-	next.green_level = GO_GREEN_LEVEL;
-	next.blue_level = GO_BLUE_LEVEL;
+	start_fade(tl, 0);
+
+	tl->button_pressed = false;
+	tl->transitioning = false;
+	tl->crosswalk_on = false;
+
+	tl->timers = timers;
+	init_swtimer(&tl->state_timer, state_timer_expired, tl);
+	init_swtimer(&tl->step_timer, step_timer_expired, tl);
+	start_swtimer(timers, &tl->state_timer, ticks_since_startup + mode_table[STOP].dwell_ticks);
+
+	tl->input = input;
+	tl->input_context = input_context;
+	tl->output = output;
 }
 
-char *mode_to_string(mode_t mode)
+const char *mode_to_string(mode_t mode)
 {
-	char *return_value;
-
-	switch(mode){
-	case STOP:
-		return_value = "STOP";
-		break;
-	case GO:
-		return_value = "GO";
-		break;
-	case WARNING:
-		return_value = "WARNING";
-		break;
-	case CROSSWALK:
-		return_value = "CROSSWALK";
-		break;
-	default:
-		return_value = "UNKNOWN";
-		break;
+	const char *return_value = "UNKNOWN";
+
+	if(mode < NUM_MODES){
+		return_value = mode_table[mode].name;
 	}
 
 	return (return_value);
@@ -116,278 +169,144 @@ char *mode_to_string(mode_t mode)
 
 uint32_t mode_state_sec(mode_t mode)
 {
-	uint32_t return_value;
-
-	switch(mode){
-	case STOP:
-		return_value = SEC_PER_STOP;
-		break;
-	case GO:
-		return_value = SEC_PER_GO;
-		break;
-	case WARNING:
-		return_value = SEC_PER_WARNING;
-		break;
-	case CROSSWALK:
-		return_value = SEC_PER_CROSSWALK;
-		break;
-	default:
-		return_value = 0;
-		break;
+	uint32_t return_value = 0;
+
+	if(mode < NUM_MODES){
+		return_value = mode_table[mode].dwell_ticks / TICK_HZ;
 	}
 
 	return (return_value);
 }
 
-bool enough_time_stable(void)
+void begin_transition(trafficlight_t *tl)
 {
-    /**
-     * Check if enough time has been spent stable in the current state (i.e. not transitioning)
-     */
-	bool return_value = false;
+	uint32_t stamp;
 
-	switch(current.mode){
-	case STOP:
-		if((ticks_spent_stable * TICK_SEC) >= SEC_PER_STOP){
-			return_value = true;
-		}
-		break;
-	case GO:
-		if((ticks_spent_stable * TICK_SEC) >= SEC_PER_GO){
-			return_value = true;
-		}
-		break;
-	case WARNING:
-		if((ticks_spent_stable * TICK_SEC) >= SEC_PER_WARNING){
-			return_value = true;
-		}
-		break;
-	case CROSSWALK:
-		if((ticks_spent_stable * TICK_SEC) >= SEC_PER_CROSSWALK){
-			return_value = true;
-		}
-		break;
-	default:
-		break;
-	}
+	tl->transitioning = true;
 
-	return (return_value);
-}
+	PROFILE_BEGIN(stamp);
+	transition_state(tl);
+	PROFILE_END(PROBE_TRANSITION_STATE, stamp);
+
+	start_swtimer(tl->timers, &tl->state_timer, ticks_since_startup + TICKS_PER_TRANSITION);
 
-bool enough_time_transitioning(void)
-{
     /**
-     * Check if enough time has been spent transitioning to the current state (i.e. not stable)
+     * Step the LEDs on every tick until the transition is over, unless the output fades on its
+     * own. Then it is handed the targets once and nothing is due until the transition is over
      */
-	if((ticks_spent_transitioning * TICK_SEC) >= SEC_PER_TRANSITION){
-		return true;
+	if(tl->fade.steps_left > 0){
+		start_swtimer(tl->timers, &tl->step_timer, ticks_since_startup + 1);
 	}
 	else{
-		return false;
+		tl->output(tl, true);
+		cancel_swtimer(&tl->step_timer);
 	}
 }
 
-bool enough_time_crosswalk_on(void)
+void begin_stable(trafficlight_t *tl)
 {
+	tl->transitioning = false;
+	start_swtimer(tl->timers, &tl->state_timer, ticks_since_startup + mode_table[tl->current.mode].dwell_ticks);
+
     /**
-     * Check if enough time has been spent keeping LED on in CROSSWALK mode for blink
+     * CROSSWALK always starts its stable period with the LEDs on
      */
-	if((ticks_spent_crosswalk_on * TICK_SEC * MSEC_PER_SEC) >= MSEC_PER_CROSSWALK_ON){
-		return true;
+	if(tl->current.mode == CROSSWALK){
+		tl->crosswalk_on = true;
+		start_swtimer(tl->timers, &tl->step_timer, ticks_since_startup + TICKS_PER_CROSSWALK_ON);
 	}
 	else{
-		return false;
+		cancel_swtimer(&tl->step_timer);
 	}
 }
 
-bool enough_time_crosswalk_off(void)
+void handle_touch(trafficlight_t *tl)
 {
     /**
-     * Check if enough time has been spent keeping LED off in CROSSWALK mode for blink
+     * Flag the button press so transition_state() heads for CROSSWALK. Any time already spent
+     * in the previous state (stable or transitioning) is dropped
      */
-	if((ticks_spent_crosswalk_off * TICK_SEC * MSEC_PER_SEC) >= MSEC_PER_CROSSWALK_OFF){
-		return true;
-	}
-	else{
-		return false;
-	}
+	tl->button_pressed = true;
+	begin_transition(tl);
 }
 
-#ifdef DEBUG
-void transition_state(void)
+void update_fsm(trafficlight_t *tl)
 {
     /**
-     * Button has been pressed so transition to CROSSWALK and set next state to GO
+     * Attribute everything timed during this tick to what the light is doing
      */
-	if(button_pressed){
-
-	    /**
-	     * Reset flag raised by touch sensor
-	     */
-		button_pressed = false;
-
-		PRINTF("%07u ms: Transitioning from %s to CROSSWALK\r\n", now(), mode_to_string(current.mode));
-		current.mode = CROSSWALK;
-
-		red_level_end = CROSSWALK_RED_LEVEL;
-		green_level_end = CROSSWALK_GREEN_LEVEL;
-		blue_level_end = CROSSWALK_BLUE_LEVEL;
-
-		next.mode = GO;
-		next.red_level = GO_RED_LEVEL;
-		next.green_level = GO_GREEN_LEVEL;
-		next.blue_level = GO_BLUE_LEVEL;
+	if(tl->transitioning){
+		PROFILE_SCENARIO(SCENARIO_FADE);
+	}
+	else if(tl->current.mode == CROSSWALK){
+		PROFILE_SCENARIO(SCENARIO_CROSSWALK);
+	}
+	else{
+		PROFILE_SCENARIO(SCENARIO_STABLE);
 	}
 
     /**
-     * Button has not been pressed so continue through FSM as normal
+     * A touch preempts whatever is scheduled, by restarting tl's timers before they are advanced.
+     * Otherwise nothing happens until one of them expires
      */
-	else{
-		switch(current.mode){
-		case STOP:
-			PRINTF("%07u ms: Transitioning from STOP to %s\r\n", now(), mode_to_string(next.mode));
-
-			current.mode = next.mode;
-
-			red_level_end = next.red_level;
-			green_level_end = next.green_level;
-			blue_level_end = next.blue_level;
-
-			next.mode = WARNING;
-			next.red_level = WARNING_RED_LEVEL;
-			next.green_level = WARNING_GREEN_LEVEL;
-			next.blue_level = WARNING_BLUE_LEVEL;
-			break;
-
-		case GO:
-			PRINTF("%07u ms: Transitioning from GO to %s\r\n", now(), mode_to_string(next.mode));
-
-			current.mode = next.mode;
-
-			red_level_end = next.red_level;
-			green_level_end = next.green_level;
-			blue_level_end = next.blue_level;
-
-			next.mode = STOP;
-			next.red_level = STOP_RED_LEVEL;
-			next.green_level = STOP_GREEN_LEVEL;
-			next.blue_level = STOP_BLUE_LEVEL;
-			break;
-
-		case WARNING:
-			PRINTF("%07u ms: Transitioning from WARNING to %s\r\n", now(), mode_to_string(next.mode));
-
-			current.mode = next.mode;
+	poll_touch(tl);
+	advance_swtimers(tl->timers, ticks_since_startup);
+}
 
-			red_level_end = next.red_level;
-			green_level_end = next.green_level;
-			blue_level_end = next.blue_level;
+bool poll_touch(trafficlight_t *tl)
+{
+	bool return_value = false;
 
-			next.mode = GO;
-			next.red_level = GO_RED_LEVEL;
-			next.green_level = GO_GREEN_LEVEL;
-			next.blue_level = GO_BLUE_LEVEL;
-			break;
+    /**
+     * A touch outside of CROSSWALK preempts whatever is scheduled. The input is sampled during
+     * CROSSWALK too, so its debounce keeps following the touchpad and a touch that was released
+     * during CROSSWALK does not still read as a touch once it is over
+     */
+	if(tl->input(tl->input_context) && tl->current.mode != CROSSWALK){
+		PROFILE_SCENARIO(SCENARIO_TOUCH);
+		handle_touch(tl);
+		return_value = true;
+	}
 
-		case CROSSWALK:
-			PRINTF("%07u ms: Transitioning from CROSSWALK to %s\r\n", now(), mode_to_string(next.mode));
+	return (return_value);
+}
 
-			current.mode = next.mode;
+void transition_state(trafficlight_t *tl)
+{
+	const mode_desc_t *entry;
 
-			red_level_end = next.red_level;
-			green_level_end = next.green_level;
-			blue_level_end = next.blue_level;
+	mode_t previous_mode = tl->current.mode;
 
-			next.mode = WARNING;
-			next.red_level = WARNING_RED_LEVEL;
-			next.green_level = WARNING_GREEN_LEVEL;
-			next.blue_level = WARNING_BLUE_LEVEL;
-			break;
-		}
-	}
-}
-#elif NDEBUG
-void transition_state(void)
-{
     /**
-     * Button has been pressed so transition to CROSSWALK and set next state to GO
+     * Button has been pressed so transition to CROSSWALK. CROSSWALK's next_mode is GO
      */
-	if(button_pressed){
+	if(tl->button_pressed){
 
 	    /**
 	     * Reset flag raised by touch sensor
 	     */
-		button_pressed = false;
+		tl->button_pressed = false;
 
-		current.mode = CROSSWALK;
-
-		red_level_end = CROSSWALK_RED_LEVEL;
-		green_level_end = CROSSWALK_GREEN_LEVEL;
-		blue_level_end = CROSSWALK_BLUE_LEVEL;
-
-		next.mode = GO;
-		next.red_level = GO_RED_LEVEL;
-		next.green_level = GO_GREEN_LEVEL;
-		next.blue_level = GO_BLUE_LEVEL;
+		tl->current.mode = CROSSWALK;
 	}
 
     /**
      * Button has not been pressed so continue through FSM as normal
      */
 	else{
-		switch(current.mode){
-		case STOP:
-			current.mode = next.mode;
-
-			red_level_end = next.red_level;
-			green_level_end = next.green_level;
-			blue_level_end = next.blue_level;
-
-			next.mode = WARNING;
-			next.red_level = WARNING_RED_LEVEL;
-			next.green_level = WARNING_GREEN_LEVEL;
-			next.blue_level = WARNING_BLUE_LEVEL;
-			break;
-
-		case GO:
-			current.mode = next.mode;
-
-			red_level_end = next.red_level;
-			green_level_end = next.green_level;
-			blue_level_end = next.blue_level;
-
-			next.mode = STOP;
-			next.red_level = STOP_RED_LEVEL;
-			next.green_level = STOP_GREEN_LEVEL;
-			next.blue_level = STOP_BLUE_LEVEL;
-			break;
-
-		case WARNING:
-			current.mode = next.mode;
-
-			red_level_end = next.red_level;
-			green_level_end = next.green_level;
-			blue_level_end = next.blue_level;
-
-			next.mode = GO;
-			next.red_level = GO_RED_LEVEL;
-			next.green_level = GO_GREEN_LEVEL;
-			next.blue_level = GO_BLUE_LEVEL;
-			break;
-
-		case CROSSWALK:
-			current.mode = next.mode;
-
-			red_level_end = next.red_level;
-			green_level_end = next.green_level;
-			blue_level_end = next.blue_level;
-
-			next.mode = WARNING;
-			next.red_level = WARNING_RED_LEVEL;
-			next.green_level = WARNING_GREEN_LEVEL;
-			next.blue_level = WARNING_BLUE_LEVEL;
-			break;
-		}
+		tl->current.mode = mode_table[tl->current.mode].next_mode;
 	}
+
+    /**
+     * Load the RGB levels of the new mode as the levels to transition towards
+     */
+	entry = &mode_table[tl->current.mode];
+
+	tl->red_level_end = entry->red_level;
+	tl->green_level_end = entry->green_level;
+	tl->blue_level_end = entry->blue_level;
+
+	start_fade(tl, FADE_TICK_STEPS);
+
+	TRACE_EVENT(TRACE_TRANSITION, previous_mode, tl->current.mode);
 }
-#endif
@@ -8,47 +8,57 @@
 #ifndef FSM_TRAFFICLIGHT_H_
 #define FSM_TRAFFICLIGHT_H_
 
+/**
+ * trafficlight_s holds its timers by value
+ */
+#include "swtimer.h"
+
+/**
+ * RGB levels below are perceptual brightness (0 to 255), not duty cycle. set_onboard_leds() maps
+ * them through the gamma table, so fades between them look even
+ */
+
 /**
  * \def		STOP_RED_LEVEL
  * \brief	The STOP state's red value (RGB)
  */
 #define STOP_RED_LEVEL\
-	(0x61)
+	(0xAD)
 
 /**
  * \def		STOP_GREEN_LEVEL
  * \brief	The STOP state's green value (RGB)
  */
 #define STOP_GREEN_LEVEL\
-	(0x1E)
+	(0x68)
 
 /**
  * \def		STOP_BLUE_LEVEL
  * \brief	The STOP state's blue value (RGB)
  */
 #define STOP_BLUE_LEVEL\
-	(0x3C)
+	(0x8E)
 
 /**
  * \def		GO_RED_LEVEL
  * \brief	The GO state's red value (RGB)
  */
 #define GO_RED_LEVEL\
-	(0x22)
+	(0x6E)
 
 /**
  * \def		GO_GREEN_LEVEL
  * \brief	The GO state's green value (RGB)
  */
 #define GO_GREEN_LEVEL\
-	(0x96)
+	(0xCF)
 
 /**
  * \def		GO_BLUE_LEVEL
  * \brief	The GO state's blue value (RGB)
  */
 #define GO_BLUE_LEVEL\
-	(0x22)
+	(0x6E)
 
 /**
  * \def		WARNING_RED_LEVEL
@@ -62,7 +72,7 @@
  * \brief	The WARNING state's green value (RGB)
  */
 #define WARNING_GREEN_LEVEL\
-	(0xB2)
+	(0xDD)
 
 /**
  * \def		WARNING_BLUE_LEVEL
@@ -83,14 +93,14 @@
  * \brief	The CROSSWALK state's green value (RGB)
  */
 #define CROSSWALK_GREEN_LEVEL\
-	(0x10)
+	(0x4C)
 
 /**
  * \def		CROSSWALK_BLUE_LEVEL
  * \brief	The CROSSWALK state's blue value (RGB)
  */
 #define CROSSWALK_BLUE_LEVEL\
-	(0x30)
+	(0x81)
 
 /**
  * \typedef	mode_t
@@ -104,6 +114,38 @@ typedef enum mode_e mode_t;
  */
 typedef struct state_s state_t;
 
+/**
+ * \typedef	fade_t
+ * \brief	To allow objects of struct fade_s to be declared with ease
+ */
+typedef struct fade_s fade_t;
+
+/**
+ * \typedef	trafficlight_t
+ * \brief	To allow objects of struct trafficlight_s to be declared with ease
+ */
+typedef struct trafficlight_s trafficlight_t;
+
+/**
+ * \typedef	led_output_t
+ * \brief	Called by the FSM whenever a traffic light's displayed colour changes. lit is false while
+ * 			CROSSWALK has blinked off
+ */
+typedef void (*led_output_t)(const trafficlight_t *tl, bool lit);
+
+/**
+ * \typedef	touch_input_t
+ * \brief	Sampled by the FSM to find out whether a pedestrian is requesting CROSSWALK. context is
+ * 			whatever the traffic light was initialized with, so each light can have its own input
+ */
+typedef bool (*touch_input_t)(void *context);
+
+/**
+ * \typedef	mode_desc_t
+ * \brief	To allow objects of struct mode_desc_s to be declared with ease
+ */
+typedef struct mode_desc_s mode_desc_t;
+
 /**
  * \enum	mode_e
  * \brief	To indicate the mode of a current state
@@ -112,7 +154,8 @@ enum mode_e {
 	STOP,
 	GO,
 	WARNING,
-	CROSSWALK
+	CROSSWALK,
+	NUM_MODES
 };
 
 /**
@@ -127,50 +170,83 @@ struct state_s {
 };
 
 /**
- * \var		extern volatile bool button_pressed
- * \brief	Declared in fsm_trafficlight.c
+ * \struct	fade_s
+ * \brief	Progress of a colour fade. Levels and steps are fixed-point with FADE_FRAC_BITS
+ * 			fraction bits, so each step of the fade is a single add per channel
  */
-extern volatile bool button_pressed;
-
-/**
- * \var		extern volatile bool transitioning
- * \brief	Declared in fsm_trafficlight.c
- */
-extern volatile bool transitioning;
+struct fade_s {
+	int32_t red_level;
+	int32_t green_level;
+	int32_t blue_level;
+	int32_t red_step;
+	int32_t green_step;
+	int32_t blue_step;
+	uint32_t steps_left;
+};
 
 /**
- * \var		extern volatile bool crosswalk_on
- * \brief	Defined in fsm_trafficlight.c
+ * \struct	mode_desc_s
+ * \brief	Holds everything that is constant about a given mode. One entry per mode in mode_table
  */
-extern volatile bool crosswalk_on;
+struct mode_desc_s {
+	mode_t next_mode;
+	uint8_t red_level;
+	uint8_t green_level;
+	uint8_t blue_level;
+	uint16_t dwell_ticks;
+	const char *name;
+};
 
 /**
- * \var		extern state_t current
- * \brief	Declared in fsm_trafficlight.c
+ * \struct	trafficlight_s
+ * \brief	Everything that belongs to one signal head (one approach of an intersection). All FSM
+ * 			functions operate on one of these, so any number of them can run side by side.
+ * 			state_timer ends the fade or the stable period, step_timer takes the next fade step or
+ * 			CROSSWALK blink toggle. Both run on the wheel timers. Members are ordered largest first
+ * 			to keep the struct compact when many are packed into an array
  */
-extern volatile state_t current;
+struct trafficlight_s {
+	swtimer_t state_timer;
+	swtimer_t step_timer;
+	swtimer_wheel_t *timers;
+	touch_input_t input;
+	void *input_context;
+	led_output_t output;
+	fade_t fade;
+	state_t current;
+	uint8_t red_level_end;
+	uint8_t green_level_end;
+	uint8_t blue_level_end;
+	bool button_pressed;
+	bool transitioning;
+	bool crosswalk_on;
+};
 
 /**
- * \var		extern state_t next
- * \brief	Declared in fsm_trafficlight.c
+ * \var		extern const mode_desc_t mode_table[NUM_MODES]
+ * \brief	Defined in fsm_trafficlight.c
  */
-extern volatile state_t next;
+extern const mode_desc_t mode_table[NUM_MODES];
 
 /**
  * \fn		void init_fsm_trafficlight
- * \param	N/A
+ * \param	trafficlight_t *tl The traffic light to initialize
+ * \param	swtimer_wheel_t *timers The wheel tl's timers run on. update_fsm() advances it
+ * \param	touch_input_t input Where tl should sample pedestrian requests from
+ * \param	void *input_context What to pass to input
+ * \param	led_output_t output Where tl should display its colour
  * \return	N/A
- * \brief   Initialize members of current state and next state
+ * \brief   Initialize tl to a stable STOP state with its state timer started
  */
-void init_fsm_trafficlight(void);
+void init_fsm_trafficlight(trafficlight_t *tl, swtimer_wheel_t *timers, touch_input_t input, void *input_context, led_output_t output);
 
 /**
- * \fn		char *mode_to_string
+ * \fn		const char *mode_to_string
  * \param	mode_t mode The mode to return as char *
  * \return	The mode in char * format
  * \brief   To make printing mode with printf easy
  */
-char *mode_to_string(mode_t mode);
+const char *mode_to_string(mode_t mode);
 
 /**
  * \fn		uint32_t mode_state_sec
@@ -181,43 +257,58 @@ char *mode_to_string(mode_t mode);
 uint32_t mode_state_sec(mode_t mode);
 
 /**
- * \fn		bool enough_time_stable
- * \param	N/A
- * \return	Returns true if enough stable time has been spent in current state
- * \brief   Checks whether enough stable time (not including time to transition) has been spent in current state
+ * \fn		void begin_transition
+ * \param	trafficlight_t *tl The traffic light
+ * \return	N/A
+ * \brief   Transition to the next state and start the timers for the first fade step and the end of
+ * 			the fade
  */
-bool enough_time_stable(void);
+void begin_transition(trafficlight_t *tl);
 
 /**
- * \fn		bool enough_time_transitioning
- * \param	N/A
- * \return	Returns true if enough time has been spent transitioning in current state
- * \brief   Checks whether enough transitioning time (not including time spent stable) has been spent in current state
+ * \fn		void begin_stable
+ * \param	trafficlight_t *tl The traffic light
+ * \return	N/A
+ * \brief   Start the stable period of the current mode (and the first blink if it is CROSSWALK)
+ * 			and start its timers. Expects the LEDs to already be at the mode's levels
  */
-bool enough_time_transitioning(void);
+void begin_stable(trafficlight_t *tl);
 
 /**
- * \fn		bool enough_time_crosswalk_on
- * \param	N/A
- * \return	Returns true if enough time has been spent keeping LED on in CROSSWALK mode for blink
- * \brief   Checks whether enough time has been spent keeping LED on in CROSSWALK mode for blink
+ * \fn		void handle_touch
+ * \param	trafficlight_t *tl The traffic light
+ * \return	N/A
+ * \brief   Preempt the current state with a transition to CROSSWALK
+ */
+void handle_touch(trafficlight_t *tl);
+
+/**
+ * \fn		void update_fsm
+ * \param	trafficlight_t *tl The traffic light
+ * \return	N/A
+ * \brief   Everything tl does on one tick: sample its input, then advance its wheel to
+ * 			ticks_since_startup so whichever of its timers is due runs. Touches nothing but tl, its
+ * 			wheel and its callbacks, so it can be driven by SysTick or by any other source of ticks
  */
-bool enough_time_crosswalk_on(void);
+void update_fsm(trafficlight_t *tl);
 
 /**
- * \fn		bool enough_time_crosswalk_off
- * \param	N/A
- * \return	Returns true if enough time has been spent keeping LED off in CROSSWALK mode for blink
- * \brief   Checks whether enough time has been spent keeping LED off in CROSSWALK mode for blink
+ * \fn		bool poll_touch
+ * \param	trafficlight_t *tl The traffic light
+ * \return	Returns true if a touch was sampled and handled
+ * \brief   Sample tl's input, and handle a touch if there is one unless tl is in CROSSWALK. Called
+ * 			by update_fsm() on every tick, and may also be called between ticks as soon as the
+ * 			input has something new, so a touch does not have to wait for the next tick
  */
-bool enough_time_crosswalk_off(void);
+bool poll_touch(trafficlight_t *tl);
 
 /**
  * \fn		void transition_state
- * \param	N/A
+ * \param	trafficlight_t *tl The traffic light
  * \return	N/A
- * \brief   Set the members of current state to reflect members of next state
+ * \brief   Move current state to the next mode in mode_table (or CROSSWALK if the button was
+ * 			pressed) and start the fade towards its RGB levels
  */
-void transition_state(void);
+void transition_state(trafficlight_t *tl);
 
 #endif /* FSM_TRAFFICLIGHT_H_ */
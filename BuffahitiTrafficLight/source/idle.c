@@ -0,0 +1,399 @@
+/**
+ * \file    idle.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Function definitions for sleeping between ticks, switching between RUN and VLPR, and
+ * 			measuring CPU duty and power mode residency
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+#include "clock_config.h"
+#include "fsl_debug_console.h"
+#include "fsl_smc.h"
+
+/**
+ * User-defined libraries
+ */
+#include "event.h"
+#include "idle.h"
+#include "lptmr.h"
+#include "systick.h"
+#include "touch.h"
+
+/**
+ * \var		uint64_t residency_counts[NUM_IDLE_MODES]
+ * \brief	SysTick counts spent in each power mode since the last report. Run is whatever is left
+ * 			of the window, so it is not counted here
+ */
+static uint64_t residency_counts[NUM_IDLE_MODES];
+
+/**
+ * \var		uint64_t window_start
+ * \brief	uptime_counts() at the last report
+ */
+static uint64_t window_start;
+
+/**
+ * \var		const uint32_t mode_ua[NUM_IDLE_MODES]
+ * \brief	Estimated supply current in uA in each power mode
+ */
+static const uint32_t mode_ua[NUM_IDLE_MODES] = {
+	[IDLE_MODE_RUN] = IDLE_RUN_UA,
+	[IDLE_MODE_WAIT] = IDLE_WAIT_UA,
+	[IDLE_MODE_VLPR] = IDLE_VLPR_UA,
+	[IDLE_MODE_VLPW] = IDLE_VLPW_UA,
+	[IDLE_MODE_VLPS] = IDLE_VLPS_UA
+};
+
+/**
+ * \var		idle_mode_t run_mode
+ * \brief	The run mode the CPU is in, IDLE_MODE_RUN or IDLE_MODE_VLPR
+ */
+static idle_mode_t run_mode = IDLE_MODE_RUN;
+
+/**
+ * \var		uint32_t awake_since
+ * \brief	systick_counts() when the CPU last woke up or switched run mode. Time awake in VLPR is
+ * 			counted from it
+ */
+static uint32_t awake_since;
+
+/**
+ * \var		uint32_t loop_max_counts[NUM_IDLE_MODES]
+ * \brief	Longest main loop in SysTick counts in each run mode since the last report
+ */
+static uint32_t loop_max_counts[NUM_IDLE_MODES];
+
+/**
+ * \var		ticktime_t console_awake_until
+ * \brief	Tick before which the console was used, so VLPS is not entered
+ */
+static ticktime_t console_awake_until;
+
+#if (TOUCH_MODE == TOUCH_MODE_WAKE) && (LPTMR_CLOCK_HZ != 1000000UL)
+#error "idle_stop() and idle_run_mode() take one LPTMR count to be 1 usec"
+#endif
+
+/**
+ * \fn		void count_awake
+ * \param	uint32_t now systick_counts() now
+ * \return	N/A
+ * \brief   Add the time since awake_since to VLPR if that is the run mode, and start again from now
+ */
+static void count_awake(uint32_t now)
+{
+	if(run_mode == IDLE_MODE_VLPR){
+		residency_counts[IDLE_MODE_VLPR] += now - awake_since;
+	}
+
+	awake_since = now;
+}
+
+#if IDLE_ENABLE && IDLE_STOP_ENABLE && (TOUCH_MODE == TOUCH_MODE_WAKE)
+
+/**
+ * \fn		bool other_interrupt_pending
+ * \param	N/A
+ * \return	Returns true if an enabled interrupt other than the LPTMR's is pending, SysTick included
+ * \brief   Anything but the LPTMR waking the CPU means there may be work for the main loop
+ */
+static bool other_interrupt_pending(void)
+{
+	return (((NVIC->ISPR[0U] & NVIC->ISER[0U] & ~(1UL << LPTMR0_IRQn)) != 0) ||
+		((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0));
+}
+
+/**
+ * \fn		uint32_t idle_stop
+ * \param	uint32_t max_periods The most LPTMR periods to stay in VLPS for
+ * \return	Ticks raised by systick_skip() for the time spent in VLPS
+ * \brief   Stay in VLPS until max_periods LPTMR periods have ended or another interrupt is
+ * 			pending. Called with interrupts masked, and unmasks them once the time is accounted for
+ */
+static uint32_t idle_stop(uint32_t max_periods)
+{
+	uint32_t return_value;
+	uint32_t periods = 0;
+	uint32_t entry_count;
+	uint32_t exit_count;
+	uint32_t slept_usec;
+
+    /**
+     * Let the last character leave the console before the CPU stops
+     */
+	while(!(UART0->S1 & UART0_S1_TC_MASK)){
+	}
+
+    /**
+     * Turn off flash speculation, which a stop can corrupt
+     */
+	SMC_PreEnterStopModes();
+
+    /**
+     * Time the stop from the LPTMR counter. If a period ends between clearing the flag and
+     * latching the counter, the counter is read again so the period is not counted twice
+     */
+	(void)lptmr_period_ended();
+	entry_count = lptmr_count();
+
+	if(lptmr_period_ended()){
+		entry_count = lptmr_count();
+	}
+
+	lptmr_interrupt(true);
+
+	do{
+		(void)SMC_SetPowerModeVlps(SMC);
+
+		if(lptmr_period_ended()){
+			periods++;
+		}
+	}while((periods < max_periods) && !other_interrupt_pending());
+
+	exit_count = lptmr_count();
+
+	if(lptmr_period_ended()){
+		periods++;
+		exit_count = lptmr_count();
+	}
+
+	lptmr_interrupt(false);
+
+    /**
+     * SMC_SetPowerModeVlps() leaves SLEEPDEEP set, and the next WFI may be meant for Wait
+     */
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+	slept_usec = (periods * LPTMR_PERIOD_COUNTS) + exit_count - entry_count;
+	residency_counts[IDLE_MODE_VLPS] += slept_usec * COUNTS_PER_USEC;
+	return_value = systick_skip(slept_usec * COUNTS_PER_USEC);
+
+    /**
+     * Turns flash speculation back on, and unmasks interrupts
+     */
+	SMC_PostExitStopModes();
+
+	return (return_value);
+}
+#endif
+
+void init_idle(void)
+{
+	SMC_SetPowerModeProtection(SMC, kSMC_AllowPowerModeVlp);
+
+    /**
+     * Interrupt on each character received and on the first start bit after the console has been
+     * quiet. Only the receiver interrupts, since PRINTF() polls the transmitter
+     */
+	UART0->S2 |= UART0_S2_RXEDGIF_MASK;
+	UART0->BDH |= UART0_BDH_RXEDGIE_MASK;
+	UART0->C2 |= UART0_C2_RIE_MASK;
+	NVIC_SetPriority(UART0_IRQn, EVENT_IRQ_PRIORITY);
+	NVIC_EnableIRQ(UART0_IRQn);
+}
+
+uint32_t idle_wait(idle_check_t work_pending, uint32_t quiet_ticks)
+{
+	uint32_t return_value = 0;
+	uint32_t start = systick_counts();
+
+#if IDLE_ENABLE && IDLE_STOP_ENABLE && (TOUCH_MODE == TOUCH_MODE_WAKE)
+	uint32_t max_periods = 0;
+#endif
+
+	count_awake(start);
+
+#if IDLE_ENABLE && IDLE_STOP_ENABLE && (TOUCH_MODE == TOUCH_MODE_WAKE)
+
+    /**
+     * Stay in VLPS through every tick but the last before the one due. SysTick then raises that
+     * one itself, on time
+     */
+	if((quiet_ticks >= IDLE_STOP_MIN_TICKS) && TICKS_REACHED(ticks_since_startup, console_awake_until)){
+
+	    /**
+	     * Clear an edge flagged while the interrupt was off (write 1 to clear), so it does not wake
+	     * the CPU as soon as the interrupt is enabled
+	     */
+		UART0->S2 |= UART0_S2_RXEDGIF_MASK;
+		UART0->BDH |= UART0_BDH_RXEDGIE_MASK;
+		max_periods = (((quiet_ticks - 1) * SYSTICK_PERIOD_COUNTS) - systick_lag()) /
+			(LPTMR_PERIOD_COUNTS * COUNTS_PER_USEC);
+	}
+#endif
+
+	__disable_irq();
+
+	if(!work_pending()){
+#if IDLE_ENABLE && IDLE_STOP_ENABLE && (TOUCH_MODE == TOUCH_MODE_WAKE)
+		if(max_periods > 0){
+			return_value = idle_stop(max_periods);
+		}
+		else
+#endif
+		{
+#if IDLE_ENABLE
+			__WFI();
+#endif
+
+		    /**
+		     * SysTick keeps counting in Wait mode. systick_counts() allows for a wrap whose
+		     * interrupt is still masked
+		     */
+			residency_counts[(run_mode == IDLE_MODE_VLPR) ? IDLE_MODE_VLPW : IDLE_MODE_WAIT] +=
+				systick_counts() - start;
+		}
+	}
+
+	awake_since = systick_counts();
+
+	__enable_irq();
+
+	return (return_value);
+}
+
+uint32_t idle_run_mode(idle_mode_t mode)
+{
+	uint32_t return_value = 0;
+
+#if IDLE_VLPR_ENABLE && (TOUCH_MODE == TOUCH_MODE_WAKE)
+	uint32_t entry_count;
+	uint32_t exit_count;
+	uint32_t switch_usec;
+
+	if(mode != run_mode){
+		__disable_irq();
+
+	    /**
+	     * Time the switch from the LPTMR counter as idle_stop() does. It is far shorter than a
+	     * period, so at most one ends during it
+	     */
+		(void)lptmr_period_ended();
+		entry_count = lptmr_count();
+
+		if(lptmr_period_ended()){
+			entry_count = lptmr_count();
+		}
+
+		systick_pause();
+
+		if(mode == IDLE_MODE_VLPR){
+			BOARD_RunClockVLPR();
+		}
+		else{
+			BOARD_RunClockRUN();
+		}
+
+		exit_count = lptmr_count();
+		switch_usec = exit_count - entry_count;
+
+		if(lptmr_period_ended()){
+			exit_count = lptmr_count();
+			switch_usec = LPTMR_PERIOD_COUNTS + exit_count - entry_count;
+		}
+
+	    /**
+	     * SysTick runs from the core clock / 16, so its LOAD changes with the mode
+	     */
+		return_value = systick_resume((mode == IDLE_MODE_VLPR) ? SYSTICK_VLPR_SCALE : 1,
+			switch_usec * COUNTS_PER_USEC);
+
+		count_awake(systick_counts());
+		run_mode = mode;
+
+		__enable_irq();
+	}
+#else
+	(void)mode;
+#endif
+
+	return (return_value);
+}
+
+void idle_loop_done(uint32_t start)
+{
+	uint32_t counts = systick_counts() - start;
+
+	if(counts > loop_max_counts[run_mode]){
+		loop_max_counts[run_mode] = counts;
+	}
+}
+
+void idle_console_active(void)
+{
+	console_awake_until = ticks_since_startup + IDLE_CONSOLE_AWAKE_TICKS;
+}
+
+void UART0_IRQHandler(void)
+{
+    /**
+     * Every bit of a character is an edge, so only the first is reported. idle_wait() arms it again
+     * once the console has been quiet for long enough to stop
+     */
+	if(UART0->S2 & UART0_S2_RXEDGIF_MASK){
+		UART0->S2 |= UART0_S2_RXEDGIF_MASK;
+		UART0->BDH &= ~UART0_BDH_RXEDGIE_MASK;
+		(void)event_publish(EVENT_CONSOLE, 0);
+	}
+
+    /**
+     * Reading S1 then D clears RDRF, and an overrun with it
+     */
+	if(UART0->S1 & (UART0_S1_RDRF_MASK | UART0_S1_OR_MASK)){
+		(void)event_publish(EVENT_COMMAND, UART0->D);
+	}
+}
+
+void idle_report(void)
+{
+	uint64_t now = uptime_counts();
+	uint64_t window;
+	uint64_t counted = 0;
+	uint32_t permille[NUM_IDLE_MODES] = {0};
+	uint32_t sleeping_ua = 0;
+	idle_mode_t mode;
+
+	count_awake((uint32_t)now);
+	window = now - window_start;
+
+	for(mode = 0; mode < NUM_IDLE_MODES; mode++){
+		if(mode != IDLE_MODE_RUN){
+			counted += residency_counts[mode];
+		}
+	}
+
+	if(window > 0){
+		permille[IDLE_MODE_RUN] = (uint32_t)((((window > counted) ? (window - counted) : 0) * 1000) / window);
+
+		for(mode = 0; mode < NUM_IDLE_MODES; mode++){
+			if(mode != IDLE_MODE_RUN){
+				permille[mode] = (uint32_t)((residency_counts[mode] * 1000) / window);
+			}
+		}
+	}
+
+	for(mode = 0; mode < NUM_IDLE_MODES; mode++){
+		sleeping_ua += mode_ua[mode] * permille[mode];
+	}
+
+	PRINTF("idle,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\r\n",
+		(uint32_t)(window / COUNTS_PER_MSEC),
+		permille[IDLE_MODE_RUN],
+		permille[IDLE_MODE_WAIT],
+		permille[IDLE_MODE_VLPR],
+		permille[IDLE_MODE_VLPW],
+		permille[IDLE_MODE_VLPS],
+		sleeping_ua / 1000,
+		IDLE_RUN_UA,
+		loop_max_counts[IDLE_MODE_RUN] / COUNTS_PER_USEC,
+		loop_max_counts[IDLE_MODE_VLPR] / COUNTS_PER_USEC);
+
+	window_start = now;
+
+	for(mode = 0; mode < NUM_IDLE_MODES; mode++){
+		residency_counts[mode] = 0;
+		loop_max_counts[mode] = 0;
+	}
+}
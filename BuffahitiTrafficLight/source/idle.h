@@ -0,0 +1,220 @@
+/**
+ * \file    idle.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Macros and function headers for sleeping between ticks and measuring CPU duty and power
+ * 			mode residency
+ */
+
+#ifndef IDLE_H_
+#define IDLE_H_
+
+/**
+ * \def		IDLE_ENABLE
+ * \brief	1 to sleep (WFI) whenever the main loop has nothing to do, 0 to spin as before. Duty is
+ * 			measured either way, so the two can be compared
+ */
+#ifndef IDLE_ENABLE
+#define IDLE_ENABLE\
+	(1)
+#endif
+
+/**
+ * \def		IDLE_STOP_ENABLE
+ * \brief	1 to enter VLPS instead of Wait when nothing is due for at least IDLE_STOP_MIN_TICKS.
+ * 			Needs IDLE_ENABLE and TOUCH_MODE_WAKE, since a polled touch scan needs the CPU on every
+ * 			tick. Off in Debug builds by default, since stop modes cut the debugger off
+ */
+#ifndef IDLE_STOP_ENABLE
+#ifdef NDEBUG
+#define IDLE_STOP_ENABLE\
+	(1)
+#else
+#define IDLE_STOP_ENABLE\
+	(0)
+#endif
+#endif
+
+/**
+ * \def		IDLE_VLPR_ENABLE
+ * \brief	1 to drop the core to 4 MHz (VLPR) whenever the main loop does not need it at full speed,
+ * 			0 to stay in RUN at 48 MHz. Needs TOUCH_MODE_WAKE, since the LPTMR times each switch
+ */
+#ifndef IDLE_VLPR_ENABLE
+#define IDLE_VLPR_ENABLE\
+	(1)
+#endif
+
+/**
+ * \def		IDLE_STOP_MIN_TICKS
+ * \brief	Fewest ticks with nothing due that are worth stopping for. Shorter gaps use Wait
+ */
+#define IDLE_STOP_MIN_TICKS\
+	(2)
+
+/**
+ * \def		IDLE_CONSOLE_AWAKE_TICKS
+ * \brief	A character arriving in VLPS may be lost, since the CPU is not there to read it. Its start
+ * 			bit still wakes the CPU, which then stays out of VLPS for this many ticks so the command
+ * 			can be sent again and read
+ */
+#define IDLE_CONSOLE_AWAKE_TICKS\
+	(SEC_TO_TICKS(10))
+
+/**
+ * \def		IDLE_REPORT_CMD
+ * \brief	Character that requests idle_report() when received on the debug console
+ */
+#define IDLE_REPORT_CMD\
+	('i')
+
+/**
+ * \def		IDLE_RUN_UA
+ * \brief	Typical supply current in uA of the KL25Z running from flash at 48 MHz core, 24 MHz bus
+ * 			(datasheet Run mode, peripheral clocks enabled). A spinning CPU draws this all the time
+ */
+#define IDLE_RUN_UA\
+	(6400)
+
+/**
+ * \def		IDLE_WAIT_UA
+ * \brief	Typical supply current in uA of the KL25Z in Wait mode (core clock gated by WFI, bus
+ * 			still at 24 MHz) per the datasheet
+ */
+#define IDLE_WAIT_UA\
+	(3700)
+
+/**
+ * \def		IDLE_VLPR_UA
+ * \brief	Estimated supply current in uA of the KL25Z in VLPR at 4 MHz core, 800 kHz bus, running
+ * 			from flash with peripheral clocks enabled (about 310 uA in the datasheet), plus what
+ * 			IDLE_VLPS_UA allows for the crystal oscillator and the modules it clocks
+ */
+#define IDLE_VLPR_UA\
+	(550)
+
+/**
+ * \def		IDLE_VLPW_UA
+ * \brief	Estimated supply current in uA of the KL25Z in VLPW, i.e. Wait entered from VLPR (about
+ * 			135 uA in the datasheet), plus the same allowance as IDLE_VLPR_UA
+ */
+#define IDLE_VLPW_UA\
+	(400)
+
+/**
+ * \def		IDLE_VLPS_UA
+ * \brief	Estimated supply current in uA of the KL25Z in VLPS with OSCERCLK kept running for the
+ * 			TPMs and LPTMR and the TSI scanning. The datasheet's few uA for VLPS itself are dwarfed
+ * 			by the crystal oscillator and the modules it clocks
+ */
+#define IDLE_VLPS_UA\
+	(300)
+
+/**
+ * \typedef	idle_mode_t
+ * \brief	To allow objects of enum idle_mode_e to be declared with ease
+ */
+typedef enum idle_mode_e idle_mode_t;
+
+/**
+ * \enum	idle_mode_e
+ * \brief	The power modes the CPU can spend its time in. RUN and VLPR are the run modes
+ */
+enum idle_mode_e {
+	IDLE_MODE_RUN,
+	IDLE_MODE_WAIT,
+	IDLE_MODE_VLPR,
+	IDLE_MODE_VLPW,
+	IDLE_MODE_VLPS,
+	NUM_IDLE_MODES
+};
+
+/**
+ * \typedef	idle_check_t
+ * \brief	Returns true if the main loop has work to do. Called with interrupts masked
+ */
+typedef bool (*idle_check_t)(void);
+
+/**
+ * \fn		void init_idle
+ * \param	N/A
+ * \return	N/A
+ * \brief   Allow the very-low-power modes (PMPROT can only be written once after reset) and let a
+ * 			start bit on the console wake the CPU. Call once, after the clocks and console are up
+ */
+void init_idle(void);
+
+/**
+ * \fn		uint32_t idle_wait
+ * \param	idle_check_t work_pending Whether the main loop has work to do
+ * \param	uint32_t quiet_ticks Ticks from ticks_since_startup to the next one with something due,
+ * 			or 0 if something running (e.g. a fade) needs the CPU or DMA on every PWM period
+ * \return	Ticks raised by systick_skip() for time spent in VLPS, which the main loop then
+ * 			processes like any other
+ * \brief   Sleep until the next interrupt unless work_pending() says there is something to do.
+ * 			Wait is VLPW while the CPU runs in VLPR.
+ * 			work_pending() and WFI run with interrupts masked, so an interrupt that makes work
+ * 			after the check still ends the sleep (the Cortex-M0+ wakes on a pending interrupt
+ * 			even while PRIMASK is set) and its handler runs as soon as they are unmasked.
+ * 			If quiet_ticks allows, sleep in VLPS rather than Wait. SysTick stops there, so the
+ * 			LPTMR wakes the CPU at the end of each of its periods to count the time, and the CPU
+ * 			goes straight back to VLPS until the tick before the one due, when it drops to Wait so
+ * 			SysTick raises that tick itself. Any other interrupt ends VLPS at once
+ */
+uint32_t idle_wait(idle_check_t work_pending, uint32_t quiet_ticks);
+
+/**
+ * \fn		uint32_t idle_run_mode
+ * \param	idle_mode_t mode IDLE_MODE_RUN for the full 48 MHz, or IDLE_MODE_VLPR for 4 MHz
+ * \return	Ticks raised by systick_skip() for the time the switch took, which the main loop then
+ * 			processes like any other
+ * \brief   Switch the core clock if it is not in mode already. SysTick is paused across the
+ * 			switch and resumed with its LOAD recomputed, and the LPTMR times the gap. The TPMs,
+ * 			LPTMR and console run from OSCERCLK, which does not change, so PWM, colours and baud
+ * 			rate are the same in both modes. Leaving VLPR waits for the PLL to lock (up to about
+ * 			1 ms). Does nothing unless IDLE_VLPR_ENABLE and TOUCH_MODE_WAKE
+ */
+uint32_t idle_run_mode(idle_mode_t mode);
+
+/**
+ * \fn		void idle_loop_done
+ * \param	uint32_t start systick_counts() when the main loop woke up
+ * \return	N/A
+ * \brief   Keep the longest time the main loop has taken to do its work in each run mode, so the
+ * 			latency cost of VLPR can be weighed against the current it saves
+ */
+void idle_loop_done(uint32_t start);
+
+/**
+ * \fn		void idle_console_active
+ * \param	N/A
+ * \return	N/A
+ * \brief   Keep out of VLPS for IDLE_CONSOLE_AWAKE_TICKS. Call on EVENT_CONSOLE and EVENT_COMMAND
+ */
+void idle_console_active(void);
+
+/**
+ * \fn		void UART0_IRQHandler
+ * \param	N/A
+ * \return	N/A
+ * \brief   The ISR for UART0, which only interrupts for the receiver. Publishes an EVENT_COMMAND
+ * 			for each character, and an EVENT_CONSOLE for the first start bit (RX active edge) after
+ * 			the console has been quiet, so the console can wake the CPU from VLPS
+ */
+void UART0_IRQHandler(void);
+
+/**
+ * \fn		void idle_report
+ * \param	N/A
+ * \return	N/A
+ * \brief   Print the residency in each power mode since the last report, the average current it
+ * 			implies and the longest loop in each run mode over the debug console:
+ * 			idle,<window ms>,<run per mille>,<wait per mille>,<vlpr per mille>,<vlpw per mille>,
+ * 			<vlps per mille>,<sleeping uA>,<spinning uA>,<run loop max usec>,<vlpr loop max usec>
+ * 			Sleeping uA mixes the IDLE_*_UA figures by residency. Spinning uA is what the same work
+ * 			costs in RUN without sleeping, i.e. IDLE_RUN_UA. Both are estimates from typical
+ * 			datasheet figures for the MCU alone, not measurements of the board
+ */
+void idle_report(void);
+
+#endif /* IDLE_H_ */
@@ -0,0 +1,257 @@
+/**
+ * \file    latency.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Function definitions for measuring touch-to-light latency
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fsl_debug_console.h"
+
+/**
+ * User-defined libraries
+ */
+#include "bitops.h"
+#include "fsm_trafficlight.h"
+#include "latency.h"
+#include "systick.h"
+
+/**
+ * \typedef	latency_hist_t
+ * \brief	To allow objects of struct latency_hist_s to be declared with ease
+ */
+typedef struct latency_hist_s latency_hist_t;
+
+/**
+ * \struct	latency_hist_s
+ * \brief	Every latency measured for one stage since boot, in SysTick counts. Buckets saturate
+ * 			rather than wrap
+ */
+struct latency_hist_s {
+	uint32_t count;
+	uint32_t max_counts;
+	uint16_t buckets[NUM_LATENCY_BUCKETS];
+};
+
+#if LATENCY_ENABLE
+/**
+ * \var		latency_hist_t latency_hists[NUM_LATENCY_STAGES]
+ * \brief	One histogram per stage
+ */
+static latency_hist_t latency_hists[NUM_LATENCY_STAGES];
+
+/**
+ * \var		uint32_t touch_scan_stamp, touch_taken_stamp, touch_lit_stamp
+ * \brief	Timestamps of the touch being measured
+ */
+static uint32_t touch_scan_stamp;
+static uint32_t touch_taken_stamp;
+static uint32_t touch_lit_stamp;
+
+/**
+ * \var		bool touch_in_flight
+ * \brief	True from latency_touch_taken() until latency_reached() finishes the measurement
+ */
+static bool touch_in_flight;
+
+/**
+ * \var		bool lit_seen
+ * \brief	True once touch_lit_stamp holds the first write of the current fade to CROSSWALK. It can be
+ * 			set before latency_touch_taken() when the fade starts while the touch is handled
+ */
+static bool lit_seen;
+
+/**
+ * \var		const char *stage_names[NUM_LATENCY_STAGES]
+ * \brief	Names printed for each stage
+ */
+static const char *const stage_names[NUM_LATENCY_STAGES] = {
+	[LATENCY_SCAN_TO_TAKEN] = "scan_to_taken",
+	[LATENCY_TAKEN_TO_LIT] = "taken_to_lit",
+	[LATENCY_LIT_TO_REACHED] = "lit_to_reached",
+	[LATENCY_TOUCH_TO_REACHED] = "touch_to_reached"
+};
+
+/**
+ * \fn		uint32_t latency_bucket
+ * \param	uint32_t counts A latency in SysTick counts
+ * \return	The bucket counts falls in
+ * \brief   Log-linear bucketing: the power of 2 of counts, then its next LATENCY_SUB_BITS bits
+ */
+static uint32_t latency_bucket(uint32_t counts)
+{
+	uint32_t return_value = counts;
+	uint32_t msb = LATENCY_SUB_BITS;
+
+	if(counts >= (1UL << LATENCY_SUB_BITS)){
+
+	    /**
+	     * Find the highest set bit. No CLZ instruction on the Cortex-M0+, and this only runs once
+	     * per measured touch
+	     */
+		while((msb <= LATENCY_MAX_MSB) && (counts >> (msb + 1))){
+			msb++;
+		}
+
+		if(msb > LATENCY_MAX_MSB){
+			return_value = NUM_LATENCY_BUCKETS - 1;
+		}
+		else{
+			return_value = ((msb - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) |
+				((counts >> (msb - LATENCY_SUB_BITS)) & (MASK(LATENCY_SUB_BITS) - 1));
+		}
+	}
+
+	return (return_value);
+}
+
+/**
+ * \fn		uint32_t latency_bucket_low
+ * \param	uint32_t bucket A bucket returned by latency_bucket()
+ * \return	The smallest latency in SysTick counts that falls in bucket
+ * \brief   The inverse of latency_bucket()
+ */
+static uint32_t latency_bucket_low(uint32_t bucket)
+{
+	uint32_t return_value = bucket;
+	uint32_t octave = bucket >> LATENCY_SUB_BITS;
+
+	if(octave > 0){
+		return_value = (MASK(LATENCY_SUB_BITS) | (bucket & (MASK(LATENCY_SUB_BITS) - 1))) << (octave - 1);
+	}
+
+	return (return_value);
+}
+
+/**
+ * \fn		void latency_add
+ * \param	latency_stage_t stage The stage measured
+ * \param	uint32_t counts How long it took, in SysTick counts
+ * \return	N/A
+ * \brief   Add one measurement to stage's histogram
+ */
+static void latency_add(latency_stage_t stage, uint32_t counts)
+{
+	latency_hist_t *hist = &latency_hists[stage];
+	uint16_t *bucket = &hist->buckets[latency_bucket(counts)];
+
+	if(*bucket < UINT16_MAX){
+		(*bucket)++;
+	}
+
+	hist->count++;
+
+	if(counts > hist->max_counts){
+		hist->max_counts = counts;
+	}
+}
+
+/**
+ * \fn		uint32_t latency_percentile_usec
+ * \param	const latency_hist_t *hist The histogram
+ * \param	uint32_t percent Which percentile, from 1 to 100
+ * \return	The top of the bucket holding the percentile (or the largest measurement if lower), in
+ * 			usec
+ * \brief   Walk the buckets until percent of the measurements have been passed
+ */
+static uint32_t latency_percentile_usec(const latency_hist_t *hist, uint32_t percent)
+{
+	uint32_t rank = ((hist->count * percent) + 99) / 100;
+	uint32_t seen = 0;
+	uint32_t bucket;
+	uint32_t counts = hist->max_counts;
+
+	for(bucket = 0; bucket < (NUM_LATENCY_BUCKETS - 1); bucket++){
+		seen += hist->buckets[bucket];
+
+		if(seen >= rank){
+			break;
+		}
+	}
+
+	/**
+	 * Nothing measured was above max_counts, which also bounds the open-ended last bucket
+	 */
+	if((bucket < (NUM_LATENCY_BUCKETS - 1)) && (latency_bucket_low(bucket + 1) - 1 < counts)){
+		counts = latency_bucket_low(bucket + 1) - 1;
+	}
+
+	return (counts / COUNTS_PER_USEC);
+}
+#endif
+
+void latency_touch_taken(uint32_t scan_stamp, uint32_t taken_stamp)
+{
+#if LATENCY_ENABLE
+	touch_scan_stamp = scan_stamp;
+	touch_taken_stamp = taken_stamp;
+	touch_in_flight = true;
+#endif
+}
+
+void latency_lit(const trafficlight_t *tl)
+{
+#if LATENCY_ENABLE
+	if(!lit_seen && tl->transitioning && (tl->current.mode == CROSSWALK)){
+		touch_lit_stamp = systick_counts();
+		lit_seen = true;
+	}
+#endif
+}
+
+void latency_reached(const trafficlight_t *tl)
+{
+#if LATENCY_ENABLE
+	uint32_t touch_reached_stamp;
+
+	if(!tl->transitioning && (tl->current.mode == CROSSWALK)){
+		if(touch_in_flight && lit_seen){
+			touch_reached_stamp = systick_counts();
+
+			latency_add(LATENCY_SCAN_TO_TAKEN, touch_taken_stamp - touch_scan_stamp);
+			latency_add(LATENCY_TAKEN_TO_LIT, touch_lit_stamp - touch_taken_stamp);
+			latency_add(LATENCY_LIT_TO_REACHED, touch_reached_stamp - touch_lit_stamp);
+			latency_add(LATENCY_TOUCH_TO_REACHED, touch_reached_stamp - touch_scan_stamp);
+		}
+
+	    /**
+	     * Whether or not it was measured, this fade to CROSSWALK is over
+	     */
+		touch_in_flight = false;
+		lit_seen = false;
+	}
+#endif
+}
+
+void latency_report(void)
+{
+#if LATENCY_ENABLE
+	latency_stage_t stage;
+	latency_hist_t *hist;
+	uint32_t bucket;
+
+	for(stage = 0; stage < NUM_LATENCY_STAGES; stage++){
+		hist = &latency_hists[stage];
+
+		PRINTF("latency,%s,%u,%u,%u,%u\r\n",
+			stage_names[stage],
+			hist->count,
+			(hist->count > 0) ? latency_percentile_usec(hist, 50) : 0,
+			(hist->count > 0) ? latency_percentile_usec(hist, 99) : 0,
+			hist->max_counts / COUNTS_PER_USEC);
+
+		for(bucket = 0; bucket < NUM_LATENCY_BUCKETS; bucket++){
+			if(hist->buckets[bucket] == 0){
+				continue;
+			}
+
+			PRINTF("latency_bucket,%s,%u,%u,%u\r\n",
+				stage_names[stage],
+				latency_bucket_low(bucket) / COUNTS_PER_USEC,
+				(latency_bucket_low(bucket + 1) - 1) / COUNTS_PER_USEC,
+				hist->buckets[bucket]);
+		}
+	}
+#endif
+}
@@ -0,0 +1,110 @@
+/**
+ * \file    latency.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Macros and function headers for measuring touch-to-light latency
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+/**
+ * \def		LATENCY_ENABLE
+ * \brief	1 to measure touch-to-light latency, 0 to compile it out of the hot path. On in every
+ * 			build by default, so a release build's latency can be read too
+ */
+#ifndef LATENCY_ENABLE
+#define LATENCY_ENABLE\
+	(1)
+#endif
+
+/**
+ * \def		LATENCY_DUMP_CMD
+ * \brief	Character that requests latency_report() when received on the debug console
+ */
+#define LATENCY_DUMP_CMD\
+	('l')
+
+/**
+ * \def		LATENCY_SUB_BITS
+ * \brief	Each power of 2 of latency is split into 2^LATENCY_SUB_BITS buckets, so a bucket is never
+ * 			wider than 1 / 2^LATENCY_SUB_BITS of the values in it
+ */
+#define LATENCY_SUB_BITS\
+	(2)
+
+/**
+ * \def		LATENCY_MAX_MSB
+ * \brief	Highest bit a latency in SysTick counts can have before it lands in the last bucket.
+ * 			2^(LATENCY_MAX_MSB + 1) counts is about 22 sec at ALT_CLOCK_HZ
+ */
+#define LATENCY_MAX_MSB\
+	(25)
+
+/**
+ * \def		NUM_LATENCY_BUCKETS
+ * \brief	Buckets per histogram. Values below 2^LATENCY_SUB_BITS get a bucket each, then every
+ * 			power of 2 up to LATENCY_MAX_MSB gets 2^LATENCY_SUB_BITS
+ */
+#define NUM_LATENCY_BUCKETS\
+	((LATENCY_MAX_MSB - LATENCY_SUB_BITS + 2) << LATENCY_SUB_BITS)
+
+/**
+ * \typedef	latency_stage_t
+ * \brief	To allow objects of enum latency_stage_e to be declared with ease
+ */
+typedef enum latency_stage_e latency_stage_t;
+
+/**
+ * \enum	latency_stage_e
+ * \brief	The intervals kept in a histogram each. The timestamps are the touch scan published by
+ * 			TSI0_IRQHandler(), the main loop starting to handle it, the first CROSSWALK colour
+ * 			handed to the LEDs, and the FSM reaching stable CROSSWALK (i.e. the fade is over)
+ */
+enum latency_stage_e {
+	LATENCY_SCAN_TO_TAKEN,
+	LATENCY_TAKEN_TO_LIT,
+	LATENCY_LIT_TO_REACHED,
+	LATENCY_TOUCH_TO_REACHED,
+	NUM_LATENCY_STAGES
+};
+
+/**
+ * \fn		void latency_touch_taken
+ * \param	uint32_t scan_stamp systick_counts() when the touch scan was published
+ * \param	uint32_t taken_stamp systick_counts() when the main loop started handling it
+ * \return	N/A
+ * \brief   Start measuring a touch that sent the traffic light to CROSSWALK
+ */
+void latency_touch_taken(uint32_t scan_stamp, uint32_t taken_stamp);
+
+/**
+ * \fn		void latency_lit
+ * \param	const trafficlight_t *tl The traffic light whose colour was just handed to the LEDs
+ * \return	N/A
+ * \brief   Call from the LED output. Marks the first write of a fade to CROSSWALK
+ */
+void latency_lit(const trafficlight_t *tl);
+
+/**
+ * \fn		void latency_reached
+ * \param	const trafficlight_t *tl The traffic light being measured
+ * \return	N/A
+ * \brief   Call after the FSM runs. Once tl is stable in CROSSWALK, finish the measurement and add
+ * 			it to the histograms
+ */
+void latency_reached(const trafficlight_t *tl);
+
+/**
+ * \fn		void latency_report
+ * \param	N/A
+ * \return	N/A
+ * \brief   Print each stage's summary and non-empty buckets over the debug console:
+ * 			latency,<stage>,<count>,<median us>,<p99 us>,<max us>
+ * 			latency_bucket,<stage>,<bucket low us>,<bucket high us>,<count>
+ * 			Percentiles are the top of the bucket they fall in, so they never understate. The last
+ * 			bucket also holds everything longer
+ */
+void latency_report(void);
+
+#endif /* LATENCY_H_ */
@@ -11,28 +11,135 @@
  * User-defined libraries
  */
 #include "bitops.h"
+#include "dma.h"
 #include "fsm_trafficlight.h"
+#include "latency.h"
 #include "led.h"
 #include "systick.h"
 #include "tpm.h"
 
 /**
- * \var		volatile uint8_t red_level_end
- * \brief	The red level current state is transitioning towards
+ * \var		const uint16_t gamma_table[NUM_LED_LEVELS]
+ * \brief	TPM count for each perceptual brightness level. Generated by the compiler from GAMMA()
+ * 			and kept const so it is placed in flash rather than RAM
  */
-volatile uint8_t red_level_end;
+static const uint16_t gamma_table[NUM_LED_LEVELS] = {
+	GAMMA_ROW(0x00), GAMMA_ROW(0x10), GAMMA_ROW(0x20), GAMMA_ROW(0x30),
+	GAMMA_ROW(0x40), GAMMA_ROW(0x50), GAMMA_ROW(0x60), GAMMA_ROW(0x70),
+	GAMMA_ROW(0x80), GAMMA_ROW(0x90), GAMMA_ROW(0xA0), GAMMA_ROW(0xB0),
+	GAMMA_ROW(0xC0), GAMMA_ROW(0xD0), GAMMA_ROW(0xE0), GAMMA_ROW(0xF0)
+};
 
 /**
- * \var		volatile uint8_t green_level_end
- * \brief	The green level current state is transitioning towards
+ * \var		fade_t pwm_fade
+ * \brief	The fade run at the PWM rate. Its levels hold what the LEDs show (or showed before
+ * 			clear_onboard_leds()), in perceptual levels with FADE_FRAC_BITS fraction bits. In
+ * 			LED_FADE_DMA mode they are only brought up to date by stop_pwm_fade(). Only touched by
+ * 			the main loop with interrupts disabled
  */
-volatile uint8_t green_level_end;
+static fade_t pwm_fade;
 
 /**
- * \var		volatile uint8_t blue_level_end
- * \brief	The blue level current state is transitioning towards
+ * \var		state_t pwm_fade_end
+ * \brief	RGB levels pwm_fade is heading for. mode is unused
  */
-volatile uint8_t blue_level_end;
+static state_t pwm_fade_end;
+
+#if LED_FADE_MODE == LED_FADE_DMA
+/**
+ * \var		uint16_t fade_waveform[NUM_LED_COLOURS][FADE_PWM_STEPS]
+ * \brief	TPM counts of every PWM period of the fade being copied by DMA, one row per colour
+ */
+static uint16_t fade_waveform[NUM_LED_COLOURS][FADE_PWM_STEPS];
+#endif
+
+/**
+ * \fn		uint16_t level_to_counts
+ * \param	int32_t level A perceptual level with FADE_FRAC_BITS fraction bits
+ * \return	The TPM count for level
+ * \brief   Interpolate between the two nearest gamma table entries, so a fade moves through every
+ * 			duty cycle between them rather than jumping a whole level at a time
+ */
+static uint16_t level_to_counts(int32_t level)
+{
+	uint32_t index = (uint32_t)level >> FADE_FRAC_BITS;
+	uint32_t fraction = (uint32_t)level & (FADE_ONE - 1);
+	uint16_t counts = gamma_table[index];
+
+	if(index < NUM_LED_LEVELS - 1){
+		counts += ((gamma_table[index + 1] - counts) * fraction) >> FADE_FRAC_BITS;
+	}
+
+	return (counts);
+}
+
+/**
+ * \fn		void advance_fade
+ * \param	fade_t *fade The fade to advance
+ * \param	const state_t *end RGB levels fade is heading for
+ * \param	uint32_t steps Number of PWM periods to advance by
+ * \return	N/A
+ * \brief   Take steps steps of fade at once. Adding a step n times is exactly the same as adding
+ * 			n times the step, so this lands where stepping one period at a time would. The last
+ * 			step snaps to end
+ */
+static void advance_fade(fade_t *fade, const state_t *end, uint32_t steps)
+{
+	if(fade->steps_left == 0){
+		return;
+	}
+
+	if(steps >= fade->steps_left){
+		fade->steps_left = 0;
+
+		fade->red_level = end->red_level * FADE_ONE;
+		fade->green_level = end->green_level * FADE_ONE;
+		fade->blue_level = end->blue_level * FADE_ONE;
+	}
+	else{
+		fade->steps_left -= steps;
+
+		fade->red_level += fade->red_step * (int32_t)steps;
+		fade->green_level += fade->green_step * (int32_t)steps;
+		fade->blue_level += fade->blue_step * (int32_t)steps;
+	}
+}
+
+/**
+ * \fn		void write_onboard_leds
+ * \param	uint16_t red_counts TPM count for the red on-board LED
+ * \param	uint16_t green_counts TPM count for the green on-board LED
+ * \param	uint16_t blue_counts TPM count for the blue on-board LED
+ * \return	N/A
+ * \brief   CnV is buffered until the counter reloads, so writing all three back to back within
+ * 			one PWM period changes the colour at once without a glitched period
+ */
+static void write_onboard_leds(uint16_t red_counts, uint16_t green_counts, uint16_t blue_counts)
+{
+	TPM2->CONTROLS[RED_LED_TPM2_CHANNEL].CnV = red_counts;
+	TPM2->CONTROLS[GREEN_LED_TPM2_CHANNEL].CnV = green_counts;
+	TPM0->CONTROLS[BLUE_LED_TPM0_CHANNEL].CnV = blue_counts;
+}
+
+/**
+ * \fn		void stop_pwm_fade
+ * \param	N/A
+ * \return	N/A
+ * \brief   Stop stepping pwm_fade, leaving its levels at what the LEDs show. Call with interrupts
+ * 			disabled
+ */
+static void stop_pwm_fade(void)
+{
+#if LED_FADE_MODE == LED_FADE_DMA
+    /**
+     * Catch up with however many periods the DMA has copied since the fade started
+     */
+	advance_fade(&pwm_fade, &pwm_fade_end, pwm_fade.steps_left - stop_dma_fade());
+#endif
+
+	pwm_fade.steps_left = 0;
+	TPM2->SC &= ~TPM_SC_TOIE_MASK;
+}
 
 void init_onboard_leds(void)
 {
@@ -74,41 +181,202 @@ void init_onboard_leds(void)
 
 void clear_onboard_leds(void)
 {
+	__disable_irq();
+
+	stop_pwm_fade();
 
     /**
      * Clear all on-board LEDs. Note that on-board LEDs are active-low
      */
-	TPM2->CONTROLS[RED_LED_TPM2_CHANNEL].CnV = 0;
-	TPM2->CONTROLS[GREEN_LED_TPM2_CHANNEL].CnV = 0;
-	TPM0->CONTROLS[BLUE_LED_TPM0_CHANNEL].CnV = 0;
+	write_onboard_leds(0, 0, 0);
+
+	__enable_irq();
+}
+
+void set_onboard_leds(const trafficlight_t *tl)
+{
+	__disable_irq();
+
+	stop_pwm_fade();
+
+	pwm_fade.red_level = tl->current.red_level * FADE_ONE;
+	pwm_fade.green_level = tl->current.green_level * FADE_ONE;
+	pwm_fade.blue_level = tl->current.blue_level * FADE_ONE;
+
+    /**
+     * Set all on-board LEDs to the current state's RGB levels. Note that on-board LEDs are active-low.
+     * The levels are perceptual, so each one costs a single table load to turn into a duty cycle
+     */
+	write_onboard_leds(
+		gamma_table[tl->current.red_level],
+		gamma_table[tl->current.green_level],
+		gamma_table[tl->current.blue_level]);
+
+	__enable_irq();
+}
+
+void fill_fade_waveform(const fade_t *start, const state_t *end, uint16_t *red_counts, uint16_t *green_counts, uint16_t *blue_counts)
+{
+	fade_t fade = *start;
+	uint32_t step;
+
+	for(step = 0; fade.steps_left > 0; step++){
+		advance_fade(&fade, end, 1);
+
+		red_counts[step] = level_to_counts(fade.red_level);
+		green_counts[step] = level_to_counts(fade.green_level);
+		blue_counts[step] = level_to_counts(fade.blue_level);
+	}
+}
+
+void fade_onboard_leds(const trafficlight_t *tl)
+{
+	__disable_irq();
+
+	stop_pwm_fade();
+
+	pwm_fade_end.red_level = tl->current.red_level;
+	pwm_fade_end.green_level = tl->current.green_level;
+	pwm_fade_end.blue_level = tl->current.blue_level;
+
+    /**
+     * Start from the displayed levels, which may be partway through an earlier fade. As with
+     * start_fade(), steps are truncated towards 0 and the last step snaps to the targets
+     */
+	pwm_fade.red_step = (pwm_fade_end.red_level * FADE_ONE - pwm_fade.red_level) / FADE_PWM_STEPS;
+	pwm_fade.green_step = (pwm_fade_end.green_level * FADE_ONE - pwm_fade.green_level) / FADE_PWM_STEPS;
+	pwm_fade.blue_step = (pwm_fade_end.blue_level * FADE_ONE - pwm_fade.blue_level) / FADE_PWM_STEPS;
+	pwm_fade.steps_left = FADE_PWM_STEPS;
+
+#if LED_FADE_MODE == LED_FADE_DMA
+    /**
+     * The whole fade is known now, so write out every period of it and let the DMA copy one per
+     * overflow without waking the CPU
+     */
+	fill_fade_waveform(&pwm_fade, &pwm_fade_end, fade_waveform[RED_LED], fade_waveform[GREEN_LED], fade_waveform[BLUE_LED]);
+	start_dma_fade(fade_waveform[RED_LED], fade_waveform[GREEN_LED], fade_waveform[BLUE_LED], FADE_PWM_STEPS);
+#else
+    /**
+     * Writing SC back also clears a stale overflow flag (write 1 to clear), so the first step is
+     * taken at the next reload
+     */
+	TPM2->SC |= TPM_SC_TOIE_MASK;
+#endif
+
+	__enable_irq();
+}
+
+bool onboard_leds_fading(void)
+{
+#if LED_FADE_MODE == LED_FADE_DMA
+	return (dma_fade_running());
+#else
+	return ((TPM2->SC & TPM_SC_TOIE_MASK) != 0);
+#endif
 }
 
-void set_onboard_leds(void)
+void output_onboard_leds(const trafficlight_t *tl, bool lit)
 {
+	if(!lit){
+		clear_onboard_leds();
+	}
+#if LED_FADE_MODE != LED_FADE_TICK
+	else if(tl->transitioning){
+		fade_onboard_leds(tl);
+	}
+#endif
+	else{
+		set_onboard_leds(tl);
+	}
+
+	/**
+	 * Now that the LEDs have the colour, time it if it is the start of a fade to CROSSWALK
+	 */
+	if(lit){
+		latency_lit(tl);
+	}
+}
+
+void start_fade(trafficlight_t *tl, uint32_t steps)
+{
+	tl->fade.steps_left = steps;
+
+	tl->fade.red_level = tl->current.red_level * FADE_ONE + FADE_HALF;
+	tl->fade.green_level = tl->current.green_level * FADE_ONE + FADE_HALF;
+	tl->fade.blue_level = tl->current.blue_level * FADE_ONE + FADE_HALF;
+
+	if(steps == 0){
+		tl->fade.red_step = 0;
+		tl->fade.green_step = 0;
+		tl->fade.blue_step = 0;
+
+		tl->current.red_level = tl->red_level_end;
+		tl->current.green_level = tl->green_level_end;
+		tl->current.blue_level = tl->blue_level_end;
+	}
+	else{
+
+	    /**
+	     * Each step is truncated towards 0, so the fade never overshoots its target and
+	     * what the last step has to absorb stays under 1 level
+	     */
+		tl->fade.red_step = ((tl->red_level_end - tl->current.red_level) * FADE_ONE) / (int32_t)steps;
+		tl->fade.green_step = ((tl->green_level_end - tl->current.green_level) * FADE_ONE) / (int32_t)steps;
+		tl->fade.blue_step = ((tl->blue_level_end - tl->current.blue_level) * FADE_ONE) / (int32_t)steps;
+	}
+}
+
+void step_leds(trafficlight_t *tl)
+{
+	if(tl->fade.steps_left == 0){
+		return;
+	}
+
+	tl->fade.steps_left--;
 
     /**
-     * Set all on-board LEDs to the current state's RGB levels. Note that on-board LEDs are active-low
+     * Snap the last step to the targets so every fade ends exactly where it was headed
      */
-	TPM2->CONTROLS[RED_LED_TPM2_CHANNEL].CnV = current.red_level;
-	TPM2->CONTROLS[GREEN_LED_TPM2_CHANNEL].CnV = current.green_level;
-	TPM0->CONTROLS[BLUE_LED_TPM0_CHANNEL].CnV = current.blue_level;
+	if(tl->fade.steps_left == 0){
+		tl->current.red_level = tl->red_level_end;
+		tl->current.green_level = tl->green_level_end;
+		tl->current.blue_level = tl->blue_level_end;
+	}
+	else{
+		tl->fade.red_level += tl->fade.red_step;
+		tl->fade.green_level += tl->fade.green_step;
+		tl->fade.blue_level += tl->fade.blue_step;
+
+		tl->current.red_level = (uint8_t)(tl->fade.red_level >> FADE_FRAC_BITS);
+		tl->current.green_level = (uint8_t)(tl->fade.green_level >> FADE_FRAC_BITS);
+		tl->current.blue_level = (uint8_t)(tl->fade.blue_level >> FADE_FRAC_BITS);
+	}
 }
 
-void step_leds(void)
+void TPM2_IRQHandler(void)
 {
 
     /**
-     * Step current state's RGB values closer to the expected RGB values of this state.
-     * This function is invoked once per tick, yet the step needs to be recalculated each time
-     * since we are dealing with integers and rounding could take us far from target RGB values.
-     * If we were dealing with floats, then the steps could be calculated during transition_state
-     * and this function would just increment the same steps per tick.
+     * Clear the overflow flag (write 1 to clear)
      */
-	int8_t red_step = (red_level_end - current.red_level) / (uint8_t)(((SEC_PER_TRANSITION * TICK_HZ)) - ticks_spent_transitioning);
-	int8_t green_step = (green_level_end - current.green_level) / (uint8_t)(((SEC_PER_TRANSITION * TICK_HZ)) - ticks_spent_transitioning);
-	int8_t blue_step = (blue_level_end - current.blue_level) / (uint8_t)(((SEC_PER_TRANSITION * TICK_HZ)) - ticks_spent_transitioning);
+	TPM2->SC |= TPM_SC_TOF_MASK;
 
-	current.red_level += red_step;
-	current.green_level += green_step;
-	current.blue_level += blue_step;
+	if(pwm_fade.steps_left == 0){
+		TPM2->SC &= ~TPM_SC_TOIE_MASK;
+		return;
+	}
+
+	advance_fade(&pwm_fade, &pwm_fade_end, 1);
+
+	if(pwm_fade.steps_left == 0){
+		TPM2->SC &= ~TPM_SC_TOIE_MASK;
+	}
+
+    /**
+     * Written at the start of the period, so both modules latch the new values at their next reload
+     */
+	write_onboard_leds(
+		level_to_counts(pwm_fade.red_level),
+		level_to_counts(pwm_fade.green_level),
+		level_to_counts(pwm_fade.blue_level));
 }
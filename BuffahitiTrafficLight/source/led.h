@@ -92,6 +92,153 @@
 #define PORTD_BLUE_LED_PIN\
 	(1)
 
+/**
+ * \def		FADE_FRAC_BITS
+ * \brief	Number of fraction bits in the fixed-point levels and steps of a fade. With 16, a fade of
+ * 			up to 65536 steps drifts less than 1 level from the exact line before its last step
+ */
+#define FADE_FRAC_BITS\
+	(16)
+
+/**
+ * \def		FADE_ONE
+ * \brief	One RGB level in fade fixed-point
+ */
+#define FADE_ONE\
+	((int32_t)1 << FADE_FRAC_BITS)
+
+/**
+ * \def		FADE_HALF
+ * \brief	Half an RGB level in fade fixed-point. Added once at the start of a fade so that
+ * 			truncating to a whole level rounds to nearest
+ */
+#define FADE_HALF\
+	(FADE_ONE >> 1)
+
+/**
+ * \def		LED_FADE_TICK
+ * \brief	LED_FADE_MODE where the FSM steps the fade on every tick and the LEDs are rewritten
+ * 			TICK_HZ times per second
+ */
+#define LED_FADE_TICK\
+	(0)
+
+/**
+ * \def		LED_FADE_PWM
+ * \brief	LED_FADE_MODE where the FSM only starts the fade and the TPM2 overflow interrupt steps
+ * 			it once per PWM period
+ */
+#define LED_FADE_PWM\
+	(1)
+
+/**
+ * \def		LED_FADE_DMA
+ * \brief	LED_FADE_MODE where the whole fade is written to RAM when it starts and the DMA copies
+ * 			one PWM period of it into the CnV registers on each TPM2 overflow, with no interrupts
+ */
+#define LED_FADE_DMA\
+	(2)
+
+/**
+ * \def		LED_FADE_MODE
+ * \brief	How the on-board LEDs fade between states, LED_FADE_TICK, LED_FADE_PWM or LED_FADE_DMA
+ */
+#ifndef LED_FADE_MODE
+#define LED_FADE_MODE\
+	(LED_FADE_DMA)
+#endif
+
+/**
+ * \def		FADE_TICK_STEPS
+ * \brief	Number of steps of a fade that the FSM takes itself, one per tick. The LEDs are
+ * 			stepped on every tick of a transition except the last, where the light becomes stable.
+ * 			0 when the output fades on its own, in which case the FSM jumps straight to the targets
+ */
+#if LED_FADE_MODE == LED_FADE_TICK
+#define FADE_TICK_STEPS\
+	(TICKS_PER_TRANSITION - 1)
+#else
+#define FADE_TICK_STEPS\
+	(0)
+#endif
+
+/**
+ * \def		FADE_PWM_STEPS
+ * \brief	Number of PWM periods, each one step of the fade, that a transition lasts in
+ * 			LED_FADE_PWM and LED_FADE_DMA modes. In LED_FADE_DMA mode the waveform takes
+ * 			2 bytes of RAM per step per colour
+ */
+#define FADE_PWM_STEPS\
+	(SEC_PER_TRANSITION * PWM_FREQ_HZ)
+
+/**
+ * \typedef	led_colour_t
+ * \brief	To allow objects of enum led_colour_e to be declared with ease
+ */
+typedef enum led_colour_e led_colour_t;
+
+/**
+ * \enum	led_colour_e
+ * \brief	The colours of the on-board RGB LED
+ */
+enum led_colour_e {
+	RED_LED,
+	GREEN_LED,
+	BLUE_LED,
+	NUM_LED_COLOURS
+};
+
+/**
+ * \def		NUM_LED_LEVELS
+ * \brief	Number of perceptual brightness levels an RGB value can take (0 to 255)
+ */
+#define NUM_LED_LEVELS\
+	(256)
+
+/**
+ * \def		CUBE(x)
+ * \param	x	The value to cube
+ * \brief	Used by GAMMA(level)
+ */
+#define CUBE(x)\
+	((x) * (x) * (x))
+
+/**
+ * \def		GAMMA(level)
+ * \param	level	Perceptual brightness level, 0 to NUM_LED_LEVELS - 1
+ * \brief	The TPM count (0 to TPM_PWM_MOD) that looks level / 255 as bright as full duty, using the
+ * 			inverse of CIE 1931 lightness: with L = 100 * level / 255, the duty is L / 903.3 for
+ * 			L <= 8 and ((L + 16) / 116)^3 above that. Integer constant expression with rounding,
+ * 			so the whole table is computed by the compiler
+ */
+#define GAMMA(level)\
+	((uint16_t)((100 * (level) <= 8 * (NUM_LED_LEVELS - 1)) ?\
+		((TPM_PWM_MOD * 1000ULL * (level) + (NUM_LED_LEVELS - 1) * 9033ULL / 2) / ((NUM_LED_LEVELS - 1) * 9033ULL)) :\
+		((TPM_PWM_MOD * CUBE(100ULL * (level) + 16 * (NUM_LED_LEVELS - 1)) + CUBE(116ULL * (NUM_LED_LEVELS - 1)) / 2) / CUBE(116ULL * (NUM_LED_LEVELS - 1)))))
+
+/**
+ * \def		GAMMA_ROW(level)
+ * \param	level	First level of the row, a multiple of 16
+ * \brief	16 consecutive entries of the gamma table
+ */
+#define GAMMA_ROW(level)\
+	GAMMA((level) + 0),\
+	GAMMA((level) + 1),\
+	GAMMA((level) + 2),\
+	GAMMA((level) + 3),\
+	GAMMA((level) + 4),\
+	GAMMA((level) + 5),\
+	GAMMA((level) + 6),\
+	GAMMA((level) + 7),\
+	GAMMA((level) + 8),\
+	GAMMA((level) + 9),\
+	GAMMA((level) + 10),\
+	GAMMA((level) + 11),\
+	GAMMA((level) + 12),\
+	GAMMA((level) + 13),\
+	GAMMA((level) + 14),\
+	GAMMA((level) + 15)
+
 /**
  * \def		RED_LED_ON()
  * \brief	Turn on on-board red LED
@@ -155,24 +302,6 @@
 #define BLUE_LED_TOGGLE()\
 	(PTD->PTOR |= MASK(PORTD_BLUE_LED_PIN))
 
-/**
- * \var		extern volatile uint8_t red_level_end
- * \brief	Defined in led.c
- */
-extern volatile uint8_t red_level_end;
-
-/**
- * \var		extern volatile uint8_t green_level_end
- * \brief	Defined in led.c
- */
- extern volatile uint8_t green_level_end;
-
-/**
- * \var		extern volatile uint8_t blue_level_end
- * \brief	Defined in led.c
- */
- extern volatile uint8_t blue_level_end;
-
 /**
  * \fn		void init_onboard_leds
  * \brief	Initialize all 3 on-board LEDs as GPIO outputs and turn them all off. Referenced
@@ -206,24 +335,94 @@ void init_onboard_leds(void);
  * \fn		void clear_onboard_leds
  * \param	N/A
  * \return	N/A
- * \brief   Clear on-board LEDs
+ * \brief   Clear on-board LEDs, cancelling any fade in progress. The next fade still starts from
+ * 			the colour shown before they were cleared
  */
 void clear_onboard_leds(void);
 
 /**
  * \fn		void set_onboard_leds
+ * \param	const trafficlight_t *tl The traffic light to display
+ * \return	N/A
+ * \brief   Set on-board LEDs based on current state's RGB values using TPM modules. Each value is
+ * 			a perceptual level and is mapped to a duty cycle through the gamma table. Cancels any fade
+ * 			in progress
+ */
+void set_onboard_leds(const trafficlight_t *tl);
+
+/**
+ * \fn		void fill_fade_waveform
+ * \param	const fade_t *start The fade as it starts, with levels in perceptual levels with
+ * 			FADE_FRAC_BITS fraction bits
+ * \param	const state_t *end RGB levels the fade is heading for
+ * \param	uint16_t *red_counts Receives start->steps_left red TPM counts
+ * \param	uint16_t *green_counts Receives start->steps_left green TPM counts
+ * \param	uint16_t *blue_counts Receives start->steps_left blue TPM counts
+ * \return	N/A
+ * \brief   Write the TPM counts of every PWM period of a fade, exactly as TPM2_IRQHandler() would
+ * 			step them. Touches no hardware
+ */
+void fill_fade_waveform(const fade_t *start, const state_t *end, uint16_t *red_counts, uint16_t *green_counts, uint16_t *blue_counts);
+
+/**
+ * \fn		void fade_onboard_leds
+ * \param	const trafficlight_t *tl The traffic light to display
+ * \return	N/A
+ * \brief   Start fading the on-board LEDs from whatever they show now towards tl's current RGB
+ * 			values over FADE_PWM_STEPS PWM periods. The fade is stepped by TPM2_IRQHandler(), or
+ * 			copied by the DMA in LED_FADE_DMA mode, so this returns straight away
+ */
+void fade_onboard_leds(const trafficlight_t *tl);
+
+/**
+ * \fn		bool onboard_leds_fading
  * \param	N/A
+ * \return	Returns true while TPM2_IRQHandler() or the DMA is still stepping a fade
+ * \brief   A fade needs the CPU or the DMA on every PWM period, so nothing that stops them may
+ * 			start until it is over. Always false in LED_FADE_TICK mode
+ */
+bool onboard_leds_fading(void);
+
+/**
+ * \fn		void output_onboard_leds
+ * \param	const trafficlight_t *tl The traffic light to display
+ * \param	bool lit Whether to show tl's current colour (true) or turn the LEDs off (false)
+ * \return	N/A
+ * \brief   led_output_t for the traffic light that owns the on-board LEDs. Unless in LED_FADE_TICK
+ * 			mode, a lit output while tl is transitioning starts a fade rather than jumping to the colour
+ */
+void output_onboard_leds(const trafficlight_t *tl, bool lit);
+
+/**
+ * \fn		void start_fade
+ * \param	trafficlight_t *tl The traffic light to fade
+ * \param	uint32_t steps Number of calls to step_leds() the fade should take (any length)
  * \return	N/A
- * \brief   Set on-board LEDs based on current state's RGB values using TPM modules
+ * \brief   Start fading tl's current RGB values towards its *_level_end values. The only
+ * 			divisions of the fade are done here, once per channel. With 0 steps the current RGB
+ * 			values are set to the targets immediately
  */
-void set_onboard_leds(void);
+void start_fade(trafficlight_t *tl, uint32_t steps);
 
 /**
  * \fn		void step_leds
+ * \param	trafficlight_t *tl The traffic light whose current RGB values to step
+ * \return	N/A
+ * \brief   Step current state's RGB values one step of the fade started by start_fade(). The
+ * 			last step lands exactly on the targets. Does nothing once the fade is over
+ */
+void step_leds(trafficlight_t *tl);
+
+/**
+ * \fn		void TPM2_IRQHandler
  * \param	N/A
  * \return	N/A
- * \brief   Calculate and step current state's RGB values
+ * \brief   The ISR for TPM2, only enabled while a fade started by fade_onboard_leds() is running.
+ * 			Takes one step of the fade per overflow and writes all three CnV registers together so
+ * 			they take effect at the same reload
+ * \detail	FUNCTION NAME IS CASE SENSITIVE. Since it is weakly defined in
+ * 			startup\startup_mkl25z4.c this definition will override
  */
-void step_leds(void);
+void TPM2_IRQHandler(void);
 
 #endif /* LED_H_ */
@@ -0,0 +1,96 @@
+/**
+ * \file    lptmr.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Function definitions for on-board LPTMR (Low-Power Timer)
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+
+/**
+ * User-defined libraries
+ */
+#include "lptmr.h"
+#include "systick.h"
+
+void init_onboard_lptmr(void)
+{
+	/**
+	 * Enable clock to LPTMR module
+	 */
+	SIM->SCGC5 |= SIM_SCGC5_LPTMR_MASK;
+
+	/**
+	 * Stop the timer while it is configured
+	 */
+	LPTMR0->CSR = 0;
+
+	/**
+	 * Keep OSCERCLK running, including in stop modes
+	 */
+	OSC0->CR |= OSC_CR_ERCLKEN_MASK | OSC_CR_EREFSTEN_MASK;
+
+	/**
+	 * Configure the LPTMR PSR register:
+	 * 	- Count OSCERCLK through the prescaler
+	 */
+	LPTMR0->PSR =
+		LPTMR_PSR_PCS(LPTMR_CLOCK_SRC) |
+		LPTMR_PSR_PRESCALE(LPTMR_PRESCALE);
+
+	/**
+	 * Load the LPTMR CMR register
+	 */
+	LPTMR0->CMR = LPTMR_CMR_COMPARE(LPTMR_PERIOD_COUNTS - 1);
+
+	/**
+	 * Configure the LPTMR CSR register:
+	 * 	- Time counter mode, resetting at the compare value
+	 * 	- Start LPTMR
+	 */
+	LPTMR0->CSR = LPTMR_CSR_TEN_MASK;
+}
+
+uint32_t lptmr_count(void)
+{
+	LPTMR0->CNR = 0;
+
+	return (LPTMR0->CNR);
+}
+
+bool lptmr_period_ended(void)
+{
+	bool return_value = false;
+
+	if(LPTMR0->CSR & LPTMR_CSR_TCF_MASK){
+
+		/**
+		 * TCF is write 1 to clear, so writing CSR back clears it and nothing else
+		 */
+		LPTMR0->CSR |= LPTMR_CSR_TCF_MASK;
+		NVIC_ClearPendingIRQ(LPTMR0_IRQn);
+		return_value = true;
+	}
+
+	return (return_value);
+}
+
+void lptmr_interrupt(bool enable)
+{
+	if(enable){
+		LPTMR0->CSR = (LPTMR0->CSR & ~LPTMR_CSR_TCF_MASK) | LPTMR_CSR_TIE_MASK;
+		NVIC_EnableIRQ(LPTMR0_IRQn);
+	}
+	else{
+		LPTMR0->CSR &= ~(LPTMR_CSR_TIE_MASK | LPTMR_CSR_TCF_MASK);
+		NVIC_DisableIRQ(LPTMR0_IRQn);
+		NVIC_ClearPendingIRQ(LPTMR0_IRQn);
+	}
+}
+
+void LPTMR0_IRQHandler(void)
+{
+	LPTMR0->CSR |= LPTMR_CSR_TCF_MASK;
+}
@@ -0,0 +1,102 @@
+/**
+ * \file    lptmr.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Macros and function headers for on-board LPTMR (Low-Power Timer)
+ */
+
+#ifndef LPTMR_H_
+#define LPTMR_H_
+
+/**
+ * \def		LPTMR_CLOCK_SRC
+ * \brief	Configuration for LPTMR prescaler clock select. OSCERCLK is the 8 MHz crystal, which is
+ * 			kept running in VLPS, so the LPTMR can also time how long the CPU was stopped
+ * \detail
+ * 		0: MCGIRCLK
+ * 		1: LPO (1 kHz, keeps running in every low-power mode)
+ * 		2: ERCLK32K
+ * 		3: OSCERCLK
+ */
+#define LPTMR_CLOCK_SRC\
+	(3)
+
+/**
+ * \def		LPTMR_PRESCALE
+ * \brief	OSCERCLK is divided by 2^(LPTMR_PRESCALE + 1)
+ */
+#define LPTMR_PRESCALE\
+	(2)
+
+/**
+ * \def		LPTMR_CLOCK_HZ
+ * \brief	The frequency the LPTMR counts at in Hz, i.e. 1 count per usec
+ */
+#define LPTMR_CLOCK_HZ\
+	(8000000UL >> (LPTMR_PRESCALE + 1))
+
+/**
+ * \def		LPTMR_PERIODS_PER_TICK
+ * \brief	LPTMR periods in a tick
+ */
+#define LPTMR_PERIODS_PER_TICK\
+	(4)
+
+/**
+ * \def		LPTMR_PERIOD_COUNTS
+ * \brief	Period of the LPTMR in LPTMR counts (15625, or 15.625 msec). Each period ends with a
+ * 			hardware trigger of a touch scan, so this is also how long a touch can go unscanned.
+ * 			A whole number of periods make a tick, and it fits the 16-bit counter
+ */
+#define LPTMR_PERIOD_COUNTS\
+	((LPTMR_CLOCK_HZ / TICK_HZ) / LPTMR_PERIODS_PER_TICK)
+
+/**
+ * \fn		void init_onboard_lptmr
+ * \param	N/A
+ * \return	N/A
+ * \brief   Start the LPTMR counting LPTMR_PERIOD_COUNTS periods from OSCERCLK. It raises no
+ * 			interrupt unless lptmr_interrupt() turns it on; other modules use the trigger it outputs
+ * 			at the end of each period
+ * \detail
+ * 		CSR:	Control Status Register, which enables the timer and its interrupt
+ * 		PSR:	Prescale Register, which selects the clock and whether it is divided
+ * 		CMR:	Compare Register. The counter resets after reaching this value, so a period is
+ * 				CMR + 1 clocks
+ */
+void init_onboard_lptmr(void);
+
+/**
+ * \fn		uint32_t lptmr_count
+ * \param	N/A
+ * \return	The LPTMR counter, from 0 to LPTMR_PERIOD_COUNTS - 1
+ * \brief   The counter can only be read after a write latches it
+ */
+uint32_t lptmr_count(void);
+
+/**
+ * \fn		bool lptmr_period_ended
+ * \param	N/A
+ * \return	Returns true if a period has ended since the last call
+ * \brief   Check and clear the compare flag (TCF), and the interrupt it may have left pending
+ */
+bool lptmr_period_ended(void);
+
+/**
+ * \fn		void lptmr_interrupt
+ * \param	bool enable Whether the end of each period should raise LPTMR0_IRQn
+ * \return	N/A
+ * \brief   The interrupt is only needed to wake the CPU from a stop mode, which works even while
+ * 			interrupts are masked. LPTMR0_IRQHandler() just clears the flag should it ever run
+ */
+void lptmr_interrupt(bool enable);
+
+/**
+ * \fn		void LPTMR0_IRQHandler
+ * \param	N/A
+ * \return	N/A
+ * \brief   The ISR for LPTMR0
+ */
+void LPTMR0_IRQHandler(void);
+
+#endif /* LPTMR_H_ */
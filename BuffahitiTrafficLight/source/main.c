@@ -47,182 +47,268 @@
  * User-defined libraries
  */
 #include "bitops.h"
+#include "dma.h"
+#include "event.h"
 #include "fsm_trafficlight.h"
+#include "idle.h"
+#include "latency.h"
 #include "led.h"
+#include "profile.h"
+#include "recorder.h"
+#include "swtimer.h"
 #include "systick.h"
+#include "task.h"
 #include "touch.h"
 #include "tpm.h"
+#include "trace.h"
 
+/**
+ * \var		trafficlight_t onboard_light
+ * \brief	The traffic light shown on the on-board RGB LED
+ */
+static trafficlight_t onboard_light;
 
-#ifdef DEBUG
-int main(void)
+/**
+ * \var		swtimer_wheel_t fsm_timers
+ * \brief	Runs the on-board traffic light's timers
+ */
+static swtimer_wheel_t fsm_timers;
+
+/**
+ * \var		ticktime_t tick_target
+ * \brief	The tick the latest EVENT_TICK raised, which TASK_FSM catches up to
+ */
+static ticktime_t tick_target;
+
+/**
+ * \var		uint32_t stopped_ticks
+ * \brief	Ticks slept through in VLPS or during a clock switch since TASK_FSM last ran
+ */
+static uint32_t stopped_ticks;
+
+/**
+ * \var		uint32_t wake_stamp
+ * \brief	systick_counts() when the main loop last woke
+ */
+static uint32_t wake_stamp;
+
+/**
+ * \var		uint32_t console_cmd
+ * \brief	The latest character received on the debug console, which TASK_CONSOLE runs
+ */
+static uint32_t console_cmd;
+
+/**
+ * \fn		bool work_pending
+ * \param	N/A
+ * \return	Returns true if an event is waiting for the main loop
+ * \brief   idle_check_t for the main loop. Every task is made ready by an event or a tick, and
+ * 			the main loop only sleeps once none is ready
+ */
+static bool work_pending(void)
 {
+	return (event_pending());
+}
 
-    /* Init board hardware. */
-    BOARD_InitBootPins();
-    BOARD_InitBootClocks();
-    BOARD_InitBootPeripherals();
-#ifndef BOARD_INIT_DEBUG_CONSOLE_PERIPHERAL
-    /* Init FSL debug console. */
-    BOARD_InitDebugConsole();
-#endif
+/**
+ * \fn		idle_mode_t run_mode_needed
+ * \param	N/A
+ * \return	IDLE_MODE_RUN if the work about to run needs the full 48 MHz, IDLE_MODE_VLPR otherwise
+ * \brief   Picked before the tasks run, so the clock switch comes ahead of the work it is for.
+ * 			Everything but a fade is a few hundred instructions per tick or touch, which VLPR's
+ * 			4 MHz covers
+ */
+static idle_mode_t run_mode_needed(void)
+{
+	idle_mode_t return_value = IDLE_MODE_VLPR;
 
+#if LED_FADE_MODE != LED_FADE_DMA
     /**
-     * Initialize all 3 on-board LEDs (red, green, blue)
+     * The CPU steps the fade, every tick or every PWM period
      */
-    init_onboard_leds();
+	if(onboard_light.transitioning || onboard_leds_fading()){
+		return_value = IDLE_MODE_RUN;
+	}
+#endif
 
     /**
-     * Initialize on-board touch sensor
+     * Starting a fade is the heaviest work there is (LED_FADE_DMA writes the whole waveform with
+     * interrupts masked). Look ahead for one starting in the ticks TASK_FSM is about to run, or on
+     * a touch. The DMA then plays the fade out without the CPU, in VLPR
      */
-    init_onboard_touch_sensor();
+	if(!onboard_light.transitioning && swtimer_expires_by(&onboard_light.state_timer, tick_target)){
+		return_value = IDLE_MODE_RUN;
+	}
 
-    /**
-     * Initialize the global current and next states
-     */
-    init_fsm_trafficlight();
+	if((onboard_light.current.mode != CROSSWALK) && touch_may_report()){
+		return_value = IDLE_MODE_RUN;
+	}
 
-    /**
-     * Initialize TPM on-board module
-     */
-    init_onboard_tpm();
+	return (return_value);
+}
 
-    /**
-     * Initialize SysTick on-board timer
-     */
-    init_onboard_systick();
+/**
+ * \fn		void fsm_task
+ * \param	void *arg The trafficlight_t to run
+ * \return	N/A
+ * \brief   TASK_FSM. Process every tick up to tick_target, one at a time, so a slow task (e.g. a
+ * 			long console print) or a dropped event delays ticks rather than losing them and fades,
+ * 			blinks and periods keep their length. Fades are stepped by the traffic light's own
+ * 			timers here, or by TPM2 or the DMA, so they are never late behind another task
+ */
+static void fsm_task(void *arg)
+{
+	trafficlight_t *trafficlight = arg;
+	uint32_t stamp;
+	uint32_t taken_stamp;
+	uint32_t scan_stamp;
+	uint32_t late_ticks = 0;
+	bool was_crosswalk;
+
+	while(!TICKS_REACHED(ticks_since_startup, tick_target)){
+
+	    /**
+	     * Increment for timestamp purposes. The FSM's timers are advanced to it
+	     */
+		ticks_since_startup++;
+		late_ticks++;
+
+	    /**
+	     * Run the traffic light for this tick
+	     */
+		taken_stamp = systick_counts();
+		was_crosswalk = (trafficlight->current.mode == CROSSWALK);
+
+		PROFILE_BEGIN(stamp);
+		update_fsm(trafficlight);
+		PROFILE_END(PROBE_LOOP, stamp);
+
+	    /**
+	     * Only a touch leads to CROSSWALK, so entering it means this tick's sample was a touch. It
+	     * is only timed if that sample came from a published scan
+	     */
+		if(!was_crosswalk && (trafficlight->current.mode == CROSSWALK) && touch_taken_stamp(&scan_stamp)){
+			latency_touch_taken(scan_stamp, taken_stamp);
+		}
+
+		latency_reached(trafficlight);
+
+		record_checkpoint(trafficlight);
+	}
 
     /**
-     * Turn on appropriate on-board LEDs based on current state
+     * The first tick was on time, any more were caught up on. Ticks slept through in VLPS or
+     * during a clock switch are counted on waking, so they are not late
      */
-	set_onboard_leds();
+	late_ticks = (late_ticks > stopped_ticks) ? (late_ticks - stopped_ticks) : 0;
+	stopped_ticks = 0;
 
-	PRINTF("%07u ms: Entering main loop...\r\n", now());
-	PRINTF("%07u ms: Initialized to %s. Staying for %u sec...\r\n", now(), mode_to_string(current.mode), mode_state_sec(current.mode));
+	if(late_ticks > 1){
+		TRACE_EVENT(TRACE_CATCHUP, (late_ticks - 1 > UINT8_MAX) ? UINT8_MAX : (late_ticks - 1), 0);
+	}
 
     /**
-     * Main infinite loop
+     * The ticks' control work is done, so the periodic tasks due by now can follow
      */
-    while(1) {
+	idle_loop_done(wake_stamp);
 
-        /**
-         * Set by SysTick_Handler every TICK_SEC
-         */
-        if(tick){
-
-            /**
-             * Reset flag that was set by SysTick ISR
-             */
-        	tick = false;
-
-            /**
-             * Increment for timestamp purposes
-             */
-        	ticks_since_startup++;
-
-            /**
-             * Increment to track stable or transitioning periods
-             */
-        	if(transitioning){
-        		ticks_spent_transitioning++;
-        	}
-        	else{
-        		ticks_spent_stable++;
-
-                /**
-                 * Increment to track CROSSWALK blink periods
-                 */
-            	if(current.mode == CROSSWALK){
-            		if(crosswalk_on){
-                		ticks_spent_crosswalk_on++;
-            		}
-            		else{
-                		ticks_spent_crosswalk_off++;
-            		}
-            	}
-        	}
-
-
-
-            /**
-             * First check if touchpad is touched and current state is not CROSSWALK.
-             * Then flag the button press, reset any ticks counted during previous state
-             * from when button was pushed, and flag the need to transition to CROSSWALK
-             */
-        	if(current.mode != CROSSWALK && touchpad_is_touched()){
-
-        		button_pressed = true;
-
-        		ticks_spent_stable = 0;
-        		ticks_spent_transitioning = 0;
-
-        		transitioning = true;
-
-        		transition_state();
-        	}
-        	else{
-        		if(!transitioning){
-
-                    /**
-                     * If we have been stable in the current state for enough time, reset stable tick
-                     * counter and begin transitioning
-                     */
-        			if(enough_time_stable()){
-						ticks_spent_stable = 0;
-						transitioning = true;
-						transition_state();
-					}
-
-        			/**
-					 * Else if we have kept the LED on for enough time this blink in the CROSSWALK state,
-					 * reset tick counter and turn off LEDs
-					 */
-        			else if(current.mode == CROSSWALK && enough_time_crosswalk_on()){
-                		ticks_spent_crosswalk_on = 0;
-            			crosswalk_on = false;
-            			clear_onboard_leds();
-            		}
-
-                    /**
-                     * Else if we have kept the LED off for enough time this blink in the CROSSWALK state,
-                     * reset tick counter and turn on LEDs
-                     */
-        			else if(current.mode == CROSSWALK && enough_time_crosswalk_off()){
-                		ticks_spent_crosswalk_off = 0;
-            			crosswalk_on = true;
-            			set_onboard_leds();
-            		}
-        		}
-        		else{
-
-        			/**
-					 * If we have been transitioning to the current state for enough time, reset
-					 * transitioning tick counter and begin tracking ticks as stable
-					 */
-        			if(enough_time_transitioning()){
-						ticks_spent_transitioning = 0;
-						transitioning = false;
-						PRINTF("%07u ms: Done transitioning to %s. Staying for %u sec...\r\n", now(), mode_to_string(current.mode), mode_state_sec(current.mode));
-					}
-
-                    /**
-                     * Else if we are transitioning but not for enough time, step the LEDs
-                     */
-        			else{
-						step_leds();
-						set_onboard_leds();
-        			}
-        		}
-        	}
+	task_advance(ticks_since_startup);
+}
 
+/**
+ * \fn		void touch_task
+ * \param	void *arg The trafficlight_t that samples the touch
+ * \return	N/A
+ * \brief   TASK_TOUCH. Handle a touch as soon as the touch sensor publishes it, without waiting
+ * 			for the tick. If it is not sampled (e.g. during CROSSWALK), drop it
+ */
+static void touch_task(void *arg)
+{
+	uint32_t taken_stamp = systick_counts();
+	uint32_t scan_stamp;
+
+	if(poll_touch(arg)){
+		if(touch_taken_stamp(&scan_stamp)){
+			latency_touch_taken(scan_stamp, taken_stamp);
+		}
+	}
+	else{
+		discard_touch();
+	}
+}
 
-        }
-    }
-    return 0;
+/**
+ * \fn		void scan_task
+ * \param	void *arg Unused
+ * \return	N/A
+ * \brief   TASK_SCAN, every tick. Arm the next touch scan. It finishes in the background and is
+ * 			taken by TASK_TOUCH or on the next tick
+ */
+static void scan_task(void *arg)
+{
+	start_touch_scan();
+}
+
+/**
+ * \fn		void trace_task
+ * \param	void *arg Unused
+ * \return	N/A
+ * \brief   TASK_TRACE, every tick. Print a bounded number of trace events
+ */
+static void trace_task(void *arg)
+{
+	uint32_t stamp;
+
+	PROFILE_BEGIN(stamp);
+	TRACE_DRAIN();
+	PROFILE_END(PROBE_TRACE_DRAIN, stamp);
+}
+
+#if PROFILE_ENABLE
+/**
+ * \fn		void profile_task
+ * \param	void *arg Unused
+ * \return	N/A
+ * \brief   TASK_PROFILE, every PROFILE_REPORT_SEC. Print what the hot path has cost since the
+ * 			last report
+ */
+static void profile_task(void *arg)
+{
+	profile_report();
+}
+#endif
+
+/**
+ * \fn		void console_task
+ * \param	void *arg Unused
+ * \return	N/A
+ * \brief   TASK_CONSOLE. Dump the input recording, the latency histograms, the CPU duty, the
+ * 			event queue or the task timing on request from the debug console (UART0). These print
+ * 			at length, so they run last
+ */
+static void console_task(void *arg)
+{
+	if(console_cmd == RECORDER_DUMP_CMD){
+		dump_recording();
+	}
+	else if(console_cmd == LATENCY_DUMP_CMD){
+		latency_report();
+	}
+	else if(console_cmd == IDLE_REPORT_CMD){
+		idle_report();
+	}
+	else if(console_cmd == EVENT_REPORT_CMD){
+		event_report();
+	}
+	else if(console_cmd == TASK_REPORT_CMD){
+		task_report();
+	}
 }
-#elif NDEBUG
+
 int main(void)
 {
+	uint32_t quiet_ticks;
+	event_t event;
 
     /* Init board hardware. */
     BOARD_InitBootPins();
@@ -244,142 +330,112 @@ int main(void)
     init_onboard_touch_sensor();
 
     /**
-     * Initialize the global current and next states
+     * Initialize the on-board traffic light's state and start its timers
      */
-    init_fsm_trafficlight();
+    init_swtimer_wheel(&fsm_timers, ticks_since_startup);
+    init_fsm_trafficlight(&onboard_light, &fsm_timers, touchpad_is_touched, NULL, output_onboard_leds);
+
+    /**
+     * Start recording the on-board traffic light's inputs
+     */
+    init_recorder(&onboard_light);
 
     /**
      * Initialize TPM on-board module
      */
     init_onboard_tpm();
 
+    /**
+     * Initialize DMA on-board module for LED fade waveforms
+     */
+    init_onboard_dma();
+
     /**
      * Initialize SysTick on-board timer
      */
     init_onboard_systick();
 
+    /**
+     * Allow the low-power modes the main loop idles in
+     */
+    init_idle();
+
+    /**
+     * Fill the task slots. Each tick runs TASK_FSM first, then the periodic tasks it makes due
+     */
+    init_task(TASK_FSM, fsm_task, &onboard_light, 0, ticks_since_startup);
+    init_task(TASK_TOUCH, touch_task, &onboard_light, 0, ticks_since_startup);
+    init_task(TASK_SCAN, scan_task, NULL, 1, ticks_since_startup);
+    init_task(TASK_TRACE, trace_task, NULL, 1, ticks_since_startup);
+#if PROFILE_ENABLE
+    init_task(TASK_PROFILE, profile_task, NULL, SEC_TO_TICKS(PROFILE_REPORT_SEC), ticks_since_startup);
+#endif
+    init_task(TASK_CONSOLE, console_task, NULL, 0, ticks_since_startup);
+
     /**
      * Turn on appropriate on-board LEDs based on current state
      */
-	set_onboard_leds();
+	set_onboard_leds(&onboard_light);
+
+	TRACE_EVENT(TRACE_BOOT, onboard_light.current.mode, 0);
 
     /**
      * Main infinite loop
      */
     while(1) {
+    	wake_stamp = systick_counts();
 
         /**
-         * Set by SysTick_Handler every TICK_SEC
+         * Take everything the interrupts have published, in the order it happened, and make the
+         * tasks it calls for ready. Then switch to the clock that work needs, run the most urgent
+         * task to completion and look again, so a tick published while a slow task runs is handled
+         * before any other ready task
          */
-        if(tick){
-
-            /**
-             * Reset flag that was set by SysTick ISR
-             */
-        	tick = false;
-
-            /**
-             * Increment for timestamp purposes
-             */
-        	ticks_since_startup++;
-
-            /**
-             * Increment to track stable or transitioning periods
-             */
-        	if(transitioning){
-        		ticks_spent_transitioning++;
-        	}
-        	else{
-        		ticks_spent_stable++;
-
-                /**
-                 * Increment to track CROSSWALK blink periods
-                 */
-            	if(current.mode == CROSSWALK){
-            		if(crosswalk_on){
-                		ticks_spent_crosswalk_on++;
-            		}
-            		else{
-                		ticks_spent_crosswalk_off++;
-            		}
-            	}
-        	}
-
-
-
-            /**
-             * First check if touchpad is touched and current state is not CROSSWALK.
-             * Then flag the button press, reset any ticks counted during previous state
-             * from when button was pushed, and flag the need to transition to CROSSWALK
-             */
-        	if(current.mode != CROSSWALK && touchpad_is_touched()){
-
-        		button_pressed = true;
-
-        		ticks_spent_stable = 0;
-        		ticks_spent_transitioning = 0;
-
-        		transitioning = true;
-
-        		transition_state();
-        	}
-        	else{
-        		if(!transitioning){
-
-                    /**
-                     * If we have been stable in the current state for enough time, reset stable tick
-                     * counter and begin transitioning
-                     */
-        			if(enough_time_stable()){
-						ticks_spent_stable = 0;
-						transitioning = true;
-						transition_state();
-					}
-
-        			/**
-					 * Else if we have kept the LED on for enough time this blink in the CROSSWALK state,
-					 * reset tick counter and turn off LEDs
-					 */
-        			else if(current.mode == CROSSWALK && enough_time_crosswalk_on()){
-                		ticks_spent_crosswalk_on = 0;
-            			crosswalk_on = false;
-            			clear_onboard_leds();
-            		}
-
-                    /**
-                     * Else if we have kept the LED off for enough time this blink in the CROSSWALK state,
-                     * reset tick counter and turn on LEDs
-                     */
-        			else if(current.mode == CROSSWALK && enough_time_crosswalk_off()){
-                		ticks_spent_crosswalk_off = 0;
-            			crosswalk_on = true;
-            			set_onboard_leds();
-            		}
-        		}
-        		else{
-
-        			/**
-					 * If we have been transitioning to the current state for enough time, reset
-					 * transitioning tick counter and begin tracking ticks as stable
-					 */
-        			if(enough_time_transitioning()){
-						ticks_spent_transitioning = 0;
-						transitioning = false;
-					}
-
-                    /**
-                     * Else if we are transitioning but not for enough time, step the LEDs
-                     */
-        			else{
-						step_leds();
-						set_onboard_leds();
-        			}
-        		}
-        	}
-
+    	do{
+    		while(event_take(&event)){
+    			switch(event.kind){
+
+    			case EVENT_TOUCH:
+    				touch_scanned(event.arg, event.stamp);
+    				task_trigger(TASK_TOUCH);
+    				break;
+
+    			case EVENT_TICK:
+    				tick_target = event.arg;
+    				task_trigger(TASK_FSM);
+    				break;
+
+    			case EVENT_CONSOLE:
+    				idle_console_active();
+    				break;
+
+    			case EVENT_COMMAND:
+    				idle_console_active();
+    				console_cmd = event.arg;
+    				task_trigger(TASK_CONSOLE);
+    				break;
+
+    			default:
+    				break;
+    			}
+    		}
+
+    		stopped_ticks += idle_run_mode(run_mode_needed());
+    	}while(task_run_next());
 
+        /**
+         * Sleep until the next interrupt (SysTick, LPTMR, touch scan, console, DMA or TPM) unless
+         * one has already left work. Nothing is due before the traffic light's next timer, unless
+         * a fade needs the TPM2 interrupt or the DMA on every PWM period
+         */
+        if(onboard_light.transitioning || onboard_leds_fading()){
+        	quiet_ticks = 0;
         }
+        else{
+        	quiet_ticks = swtimer_quiet_ticks(&fsm_timers);
+        }
+
+        stopped_ticks += idle_wait(work_pending, quiet_ticks);
     }
     return 0;
 }
-#endif
@@ -0,0 +1,124 @@
+/**
+ * \file    profile.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Function definitions for on-target profiling of the per-tick hot path
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+#include "fsl_debug_console.h"
+
+/**
+ * User-defined libraries
+ */
+#include "profile.h"
+#include "systick.h"
+
+/**
+ * \typedef	profile_stat_t
+ * \brief	To allow objects of struct profile_stat_s to be declared with ease
+ */
+typedef struct profile_stat_s profile_stat_t;
+
+/**
+ * \struct	profile_stat_s
+ * \brief	Accumulated timing of one probe in one scenario, in SysTick counts and in core cycles
+ * 			at the clock each call ran at
+ */
+struct profile_stat_s {
+	uint32_t calls;
+	uint32_t total_counts;
+	uint32_t total_cycles;
+	uint32_t max_cycles;
+};
+
+/**
+ * \var		profile_scenario_t profile_scenario
+ * \brief	The scenario that probes are currently attributed to
+ */
+profile_scenario_t profile_scenario = SCENARIO_STABLE;
+
+/**
+ * \var		profile_stat_t profile_stats[NUM_SCENARIOS][NUM_PROBES]
+ * \brief	Timing accumulated since the last report
+ */
+static profile_stat_t profile_stats[NUM_SCENARIOS][NUM_PROBES];
+
+/**
+ * \var		const char *probe_names[NUM_PROBES]
+ * \brief	Names printed for each probe
+ */
+static const char *const probe_names[NUM_PROBES] = {
+	[PROBE_LOOP] = "loop",
+	[PROBE_STEP_LEDS] = "step_leds",
+	[PROBE_TRANSITION_STATE] = "transition_state",
+	[PROBE_GET_TOUCH] = "get_touch",
+	[PROBE_TRACE_DRAIN] = "trace_drain"
+};
+
+/**
+ * \var		const char *scenario_names[NUM_SCENARIOS]
+ * \brief	Names printed for each scenario
+ */
+static const char *const scenario_names[NUM_SCENARIOS] = {
+	[SCENARIO_STABLE] = "stable",
+	[SCENARIO_FADE] = "fade",
+	[SCENARIO_CROSSWALK] = "crosswalk",
+	[SCENARIO_TOUCH] = "touch"
+};
+
+void profile_record(profile_probe_t probe, uint32_t start, uint32_t end)
+{
+	profile_stat_t *stat = &profile_stats[profile_scenario][probe];
+	uint32_t counts = end - start;
+	uint32_t cycles = (uint32_t)systick_cycles(counts);
+
+	stat->calls++;
+	stat->total_counts += counts;
+	stat->total_cycles += cycles;
+
+	if(cycles > stat->max_cycles){
+		stat->max_cycles = cycles;
+	}
+}
+
+void profile_report(void)
+{
+	profile_scenario_t scenario;
+	profile_probe_t probe;
+	profile_stat_t *stat;
+	uint32_t avg_ns;
+
+	for(scenario = 0; scenario < NUM_SCENARIOS; scenario++){
+		for(probe = 0; probe < NUM_PROBES; probe++){
+			stat = &profile_stats[scenario][probe];
+
+			if(stat->calls == 0){
+				continue;
+			}
+
+		    /**
+		     * Convert to ns with 64-bit integer math; this only runs once per report
+		     */
+			avg_ns = (uint32_t)(((uint64_t)stat->total_counts * 1000000000ULL) / ((uint64_t)stat->calls * ALT_CLOCK_HZ));
+
+			PRINTF("profile,%s,%s,%u,%u,%u,%u\r\n",
+				scenario_names[scenario],
+				probe_names[probe],
+				stat->calls,
+				stat->total_cycles / stat->calls,
+				stat->max_cycles,
+				avg_ns);
+
+		    /**
+		     * Each report covers only the time since the previous one
+		     */
+			stat->calls = 0;
+			stat->total_counts = 0;
+			stat->total_cycles = 0;
+			stat->max_cycles = 0;
+		}
+	}
+}
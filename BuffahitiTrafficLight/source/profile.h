@@ -0,0 +1,131 @@
+/**
+ * \file    profile.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Macros and function headers for on-target profiling of the per-tick hot path
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+/**
+ * \def		PROFILE_ENABLE
+ * \brief	1 to compile the probes in, 0 to compile them out entirely. On by default in DEBUG only
+ */
+#ifndef PROFILE_ENABLE
+#ifdef DEBUG
+#define PROFILE_ENABLE\
+	(1)
+#else
+#define PROFILE_ENABLE\
+	(0)
+#endif
+#endif
+
+/**
+ * \def		PROFILE_REPORT_SEC
+ * \brief	How often in sec the accumulated profile is printed
+ */
+#define PROFILE_REPORT_SEC\
+	(60)
+
+/**
+ * \typedef	profile_probe_t
+ * \brief	To allow objects of enum profile_probe_e to be declared with ease
+ */
+typedef enum profile_probe_e profile_probe_t;
+
+/**
+ * \typedef	profile_scenario_t
+ * \brief	To allow objects of enum profile_scenario_e to be declared with ease
+ */
+typedef enum profile_scenario_e profile_scenario_t;
+
+/**
+ * \enum	profile_probe_e
+ * \brief	The pieces of code that are timed
+ */
+enum profile_probe_e {
+	PROBE_LOOP,
+	PROBE_STEP_LEDS,
+	PROBE_TRANSITION_STATE,
+	PROBE_GET_TOUCH,
+	PROBE_TRACE_DRAIN,
+	NUM_PROBES
+};
+
+/**
+ * \enum	profile_scenario_e
+ * \brief	What the traffic light was doing when a probe ran. Results are kept per scenario so
+ * 			that a cheap stable tick doesn't hide an expensive fade tick
+ */
+enum profile_scenario_e {
+	SCENARIO_STABLE,
+	SCENARIO_FADE,
+	SCENARIO_CROSSWALK,
+	SCENARIO_TOUCH,
+	NUM_SCENARIOS
+};
+
+#if PROFILE_ENABLE
+/**
+ * \def		PROFILE_BEGIN(stamp)
+ * \param	stamp A uint32_t to hold the start time
+ * \brief	Start timing a probe
+ */
+#define PROFILE_BEGIN(stamp)\
+	((stamp) = systick_counts())
+
+/**
+ * \def		PROFILE_END(probe, stamp)
+ * \param	probe	The profile_probe_t being timed
+ * \param	stamp	The uint32_t handed to PROFILE_BEGIN
+ * \brief	Stop timing a probe and accumulate the result under the current scenario
+ */
+#define PROFILE_END(probe, stamp)\
+	(profile_record((probe), (stamp), systick_counts()))
+
+/**
+ * \def		PROFILE_SCENARIO(scenario)
+ * \param	scenario The profile_scenario_t that following probes belong to
+ * \brief	Attribute following probes to scenario
+ */
+#define PROFILE_SCENARIO(scenario)\
+	(profile_scenario = (scenario))
+#else
+#define PROFILE_BEGIN(stamp)\
+	((stamp) = 0)
+#define PROFILE_END(probe, stamp)\
+	((void)(stamp))
+#define PROFILE_SCENARIO(scenario)\
+	((void)0)
+#endif
+
+/**
+ * \var		extern profile_scenario_t profile_scenario
+ * \brief	Defined in profile.c
+ */
+extern profile_scenario_t profile_scenario;
+
+/**
+ * \fn		void profile_record
+ * \param	profile_probe_t probe The probe that was timed
+ * \param	uint32_t start systick_counts() when the probe started
+ * \param	uint32_t end systick_counts() when the probe ended
+ * \return	N/A
+ * \brief   Accumulate one call of probe under the current scenario
+ */
+void profile_record(profile_probe_t probe, uint32_t start, uint32_t end);
+
+/**
+ * \fn		void profile_report
+ * \param	N/A
+ * \return	N/A
+ * \brief   Print every probe/scenario pair that ran as one CSV line over the debug console:
+ * 			profile,<scenario>,<probe>,<calls>,<avg cycles>,<max cycles>,<avg ns>
+ * 			Cycles are of the core clock each call ran at, so a call in VLPR takes fewer cycles than
+ * 			its ns suggest
+ */
+void profile_report(void);
+
+#endif /* PROFILE_H_ */
@@ -0,0 +1,354 @@
+/**
+ * \file    recorder.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Function definitions for recording and replaying the controller's inputs
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fsl_debug_console.h"
+
+/**
+ * User-defined libraries
+ */
+#include "fsm_trafficlight.h"
+#include "recorder.h"
+#include "swtimer.h"
+#include "systick.h"
+#include "touch.h"
+#include "touch_filter.h"
+
+/**
+ * \var		record_t records[RECORDER_DEPTH]
+ * \brief	Ring of recorded inputs
+ */
+static record_t records[RECORDER_DEPTH];
+
+/**
+ * \var		uint16_t oldest
+ * \brief	Index in records of the oldest record
+ */
+static uint16_t oldest;
+
+/**
+ * \var		uint16_t count
+ * \brief	Number of records in the ring
+ */
+static uint16_t count;
+
+/**
+ * \var		ticktime_t oldest_tick
+ * \brief	Tick of the oldest record. The delta of the oldest record itself is meaningless
+ */
+static ticktime_t oldest_tick;
+
+/**
+ * \var		ticktime_t newest_tick
+ * \brief	Tick of the newest record, which the next record's delta is taken from
+ */
+static ticktime_t newest_tick;
+
+/**
+ * \var		uint32_t checkpoint_deadline
+ * \brief	Expiry of the state timer at the last checkpoint, so each stable period is checkpointed once
+ */
+static uint32_t checkpoint_deadline;
+
+/**
+ * \var		ticktime_t updated_tick
+ * \brief	The latest tick record_checkpoint() was called on, i.e. whose update_fsm() is over
+ */
+static ticktime_t updated_tick;
+
+#if RECORDER_REPLAY
+/**
+ * \var		bool replay_late
+ * \brief	True while the replay samples after the tick's update_fsm(), so only REC_TOUCH_LATE is
+ * 			taken
+ */
+static bool replay_late;
+
+/**
+ * \var		uint16_t replay_next
+ * \brief	Offset from oldest of the next record the replay has not consumed yet
+ */
+static uint16_t replay_next;
+
+/**
+ * \var		ticktime_t replay_next_tick
+ * \brief	Tick of the record at replay_next
+ */
+static ticktime_t replay_next_tick;
+
+/**
+ * \var		swtimer_wheel_t replay_timers
+ * \brief	Runs the replayed traffic light's timers, apart from whatever wheel the live one uses
+ */
+static swtimer_wheel_t replay_timers;
+#endif
+
+/**
+ * \fn		record_t *nth_record
+ * \param	uint16_t n Offset from the oldest record
+ * \return	The nth oldest record
+ * \brief   RECORDER_DEPTH is a power of 2, so the modulo reduces to a mask
+ */
+static record_t *nth_record(uint16_t n)
+{
+	return (&records[(oldest + n) % RECORDER_DEPTH]);
+}
+
+/**
+ * \fn		void append_record
+ * \param	record_kind_t kind The kind of record
+ * \param	uint8_t delta Ticks since the newest record
+ * \param	uint16_t value What the record holds
+ * \return	N/A
+ * \brief   Append one record, overwriting the oldest once the ring is full
+ */
+static void append_record(record_kind_t kind, uint8_t delta, uint16_t value)
+{
+	record_t *record;
+
+	if(count == RECORDER_DEPTH){
+		oldest = (oldest + 1) % RECORDER_DEPTH;
+		count--;
+		oldest_tick += records[oldest].delta;
+	}
+
+	record = nth_record(count);
+	record->kind = kind;
+	record->delta = delta;
+	record->value = value;
+
+	count++;
+	newest_tick += delta;
+
+	if(count == 1){
+		oldest_tick = newest_tick;
+	}
+}
+
+/**
+ * \fn		void push_record
+ * \param	record_kind_t kind The kind of record
+ * \param	uint16_t value What the record holds
+ * \return	N/A
+ * \brief   Record something that happened this tick, bridging long gaps with REC_GAP records
+ */
+static void push_record(record_kind_t kind, uint16_t value)
+{
+	ticktime_t delta = ticks_since_startup - newest_tick;
+
+	while(delta > RECORDER_MAX_DELTA){
+		append_record(REC_GAP, RECORDER_MAX_DELTA, 0);
+		delta -= RECORDER_MAX_DELTA;
+	}
+
+	append_record(kind, (uint8_t)delta, value);
+}
+
+#if RECORDER_REPLAY
+/**
+ * \fn		void replay_advance
+ * \param	N/A
+ * \return	N/A
+ * \brief   Move the replay on to the next record
+ */
+static void replay_advance(void)
+{
+	replay_next++;
+
+	if(replay_next < count){
+		replay_next_tick += nth_record(replay_next)->delta;
+	}
+}
+
+/**
+ * \fn		record_t *replay_due
+ * \param	N/A
+ * \return	The next touch sample recorded at or before this tick, or NULL if there is none
+ * \brief   Move the replay past the gaps and checkpoints in front of the next touch sample
+ */
+static record_t *replay_due(void)
+{
+	record_t *return_value = NULL;
+
+	while(replay_next < count && TICKS_REACHED(ticks_since_startup, replay_next_tick)){
+		return_value = nth_record(replay_next);
+
+		if(return_value->kind == REC_TOUCH || return_value->kind == REC_TOUCH_LATE){
+			break;
+		}
+
+		return_value = NULL;
+		replay_advance();
+	}
+
+	return (return_value);
+}
+
+/**
+ * \fn		bool replay_input
+ * \param	void *context Unused, there is only one recording
+ * \return	Whether the recorded touch sample for this call counts as a touch
+ * \brief   touch_input_t used during a replay. Takes the next sample if it was recorded by the
+ * 			same kind of call (in update_fsm() or after it), and feeds its level through the same
+ * 			detector the live touchpad uses. A call that took no sample live finds none here either
+ */
+static bool replay_input(void *context)
+{
+	bool return_value = false;
+	record_t *record = replay_due();
+
+	if(record != NULL && record->kind == (replay_late ? REC_TOUCH_LATE : REC_TOUCH)){
+		return_value = touch_detect(record->value);
+		replay_advance();
+	}
+
+	return (return_value);
+}
+
+/**
+ * \fn		void replay_late_polls
+ * \param	trafficlight_t *tl The replayed traffic light
+ * \return	N/A
+ * \brief   After the tick's update_fsm(), poll tl once for each REC_TOUCH_LATE recorded this tick,
+ * 			as the live controller may have polled several touches before the next tick (e.g.
+ * 			several scans in TOUCH_MODE_WAKE). Then drop whatever else is left of the tick
+ */
+static void replay_late_polls(trafficlight_t *tl)
+{
+	replay_late = true;
+
+	while(replay_due() != NULL && nth_record(replay_next)->kind == REC_TOUCH_LATE){
+		poll_touch(tl);
+	}
+
+	while(replay_next < count && TICKS_REACHED(ticks_since_startup, replay_next_tick)){
+		replay_advance();
+	}
+}
+#endif
+
+void init_recorder(const trafficlight_t *tl)
+{
+	oldest = 0;
+	count = 0;
+	newest_tick = ticks_since_startup;
+
+	checkpoint_deadline = tl->state_timer.expiry;
+	push_record(REC_CHECKPOINT, tl->current.mode);
+
+	updated_tick = ticks_since_startup;
+}
+
+void record_touch(uint32_t reading)
+{
+#if RECORDER_ENABLE
+	push_record((updated_tick == ticks_since_startup) ? REC_TOUCH_LATE : REC_TOUCH, (uint16_t)reading);
+#endif
+}
+
+void record_checkpoint(const trafficlight_t *tl)
+{
+#if RECORDER_ENABLE
+	updated_tick = ticks_since_startup;
+
+	if(!tl->transitioning && tl->state_timer.expiry != checkpoint_deadline){
+		checkpoint_deadline = tl->state_timer.expiry;
+		push_record(REC_CHECKPOINT, tl->current.mode);
+	}
+#endif
+}
+
+void dump_recording(void)
+{
+	uint16_t n;
+	record_t *record;
+
+	PRINTF("recording,%u,%u\r\n", oldest_tick, count);
+
+	for(n = 0; n < count; n++){
+		record = nth_record(n);
+		PRINTF("record,%u,%u,%u\r\n", record->kind, record->delta, record->value);
+	}
+}
+
+#if RECORDER_REPLAY
+void load_recording(uint32_t first_tick, const record_t *loaded, uint16_t loaded_count)
+{
+	uint16_t n;
+
+	oldest = 0;
+	count = 0;
+	newest_tick = first_tick;
+
+	for(n = 0; n < loaded_count; n++){
+		append_record((record_kind_t)loaded[n].kind, (n == 0) ? 0 : loaded[n].delta, loaded[n].value);
+	}
+}
+
+uint32_t replay_recording(trafficlight_t *tl, led_output_t output)
+{
+	ticktime_t end = ticks_since_startup;
+	ticktime_t tick = oldest_tick;
+	ticktime_t start;
+	uint16_t n;
+
+    /**
+     * Everything before the oldest checkpoint depends on state that is no longer recorded
+     */
+	for(n = 0; n < count; n++){
+		if(n > 0){
+			tick += nth_record(n)->delta;
+		}
+
+		if(nth_record(n)->kind == REC_CHECKPOINT){
+			break;
+		}
+	}
+
+	if(n == count){
+		return (0);
+	}
+
+    /**
+     * Rebuild the stable state the checkpoint describes
+     */
+	ticks_since_startup = tick;
+	start = tick;
+
+	init_swtimer_wheel(&replay_timers, tick);
+	init_fsm_trafficlight(tl, &replay_timers, replay_input, NULL, output);
+	tl->current.mode = (mode_t)nth_record(n)->value;
+	tl->current.red_level = mode_table[tl->current.mode].red_level;
+	tl->current.green_level = mode_table[tl->current.mode].green_level;
+	tl->current.blue_level = mode_table[tl->current.mode].blue_level;
+	tl->red_level_end = tl->current.red_level;
+	tl->green_level_end = tl->current.green_level;
+	tl->blue_level_end = tl->current.blue_level;
+	begin_stable(tl);
+
+	replay_next = n;
+	replay_next_tick = tick;
+	replay_advance();
+
+    /**
+     * Run the FSM tick by tick up to the tick the replay was started at, so that the replay also
+     * covers the time after the newest record. The checkpoint's own tick already had its
+     * update_fsm(), but may have had touches polled after it
+     */
+	replay_late_polls(tl);
+
+	while(!TICKS_REACHED(ticks_since_startup, end)){
+		ticks_since_startup++;
+		replay_late = false;
+		update_fsm(tl);
+		replay_late_polls(tl);
+	}
+
+	return (ticks_since_startup - start);
+}
+#endif
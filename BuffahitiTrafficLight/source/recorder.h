@@ -0,0 +1,153 @@
+/**
+ * \file    recorder.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Macros and function headers for recording and replaying the controller's inputs
+ */
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+/**
+ * \def		RECORDER_ENABLE
+ * \brief	1 to record inputs into RAM, 0 to compile the recorder out of the hot path
+ */
+#ifndef RECORDER_ENABLE
+#define RECORDER_ENABLE\
+	(1)
+#endif
+
+/**
+ * \def		RECORDER_REPLAY
+ * \brief	1 to build replay_recording() and load_recording(). Only the host replay target does,
+ * 			since a replay drives ticks_since_startup itself and can't run alongside the controller
+ */
+#ifndef RECORDER_REPLAY
+#define RECORDER_REPLAY\
+	(0)
+#endif
+
+/**
+ * \def		RECORDER_DEPTH
+ * \brief	Number of records kept (a power of 2). Once full, the oldest record is overwritten.
+ * 			Each record is 4 bytes, and at one touch sample per tick this covers about
+ * 			RECORDER_DEPTH / TICK_HZ sec
+ */
+#ifndef RECORDER_DEPTH
+#define RECORDER_DEPTH\
+	(256)
+#endif
+
+/**
+ * \def		RECORDER_MAX_DELTA
+ * \brief	Largest tick delta a single record can hold. Longer gaps are bridged with REC_GAP
+ */
+#define RECORDER_MAX_DELTA\
+	(UINT8_MAX)
+
+/**
+ * \def		RECORDER_DUMP_CMD
+ * \brief	Character that requests dump_recording() when received on the debug console
+ */
+#define RECORDER_DUMP_CMD\
+	('r')
+
+/**
+ * \typedef	record_kind_t
+ * \brief	To allow objects of enum record_kind_e to be declared with ease
+ */
+typedef enum record_kind_e record_kind_t;
+
+/**
+ * \typedef	record_t
+ * \brief	To allow objects of struct record_s to be declared with ease
+ */
+typedef struct record_s record_t;
+
+/**
+ * \enum	record_kind_e
+ * \brief	What a record holds in its value
+ */
+enum record_kind_e {
+	REC_GAP,
+	REC_TOUCH,
+	REC_CHECKPOINT,
+	REC_TOUCH_LATE
+};
+
+/**
+ * \struct	record_s
+ * \brief	One recorded input. delta is the number of ticks since the previous record.
+ * 			value is the filter_touch() level for REC_TOUCH (sampled by the tick's update_fsm()) and
+ * 			REC_TOUCH_LATE (sampled by a poll_touch() after it), or the mode the traffic light
+ * 			became stable in for REC_CHECKPOINT
+ */
+struct record_s {
+	uint8_t kind;
+	uint8_t delta;
+	uint16_t value;
+};
+
+/**
+ * \fn		void init_recorder
+ * \param	const trafficlight_t *tl The traffic light being recorded, freshly initialized
+ * \return	N/A
+ * \brief   Empty the recording and checkpoint tl's initial stable state
+ */
+void init_recorder(const trafficlight_t *tl);
+
+/**
+ * \fn		void record_touch
+ * \param	uint32_t reading The filter_touch() level sampled this tick
+ * \return	N/A
+ * \brief   Record one touch sample, as REC_TOUCH_LATE if record_checkpoint() has already been
+ * 			called this tick
+ */
+void record_touch(uint32_t reading);
+
+/**
+ * \fn		void record_checkpoint
+ * \param	const trafficlight_t *tl The traffic light being recorded
+ * \return	N/A
+ * \brief   Call once per tick after update_fsm(). Records a checkpoint whenever tl has just become
+ * 			stable, since that state is fully described by its mode and the current tick. Also marks
+ * 			the end of the tick's update_fsm(), so later samples are told apart
+ */
+void record_checkpoint(const trafficlight_t *tl);
+
+/**
+ * \fn		void dump_recording
+ * \param	N/A
+ * \return	N/A
+ * \brief   Print the recording over the debug console, oldest record first:
+ * 			recording,<tick of oldest record>,<number of records>
+ * 			record,<kind>,<delta>,<value>
+ */
+void dump_recording(void);
+
+#if RECORDER_REPLAY
+/**
+ * \fn		void load_recording
+ * \param	uint32_t first_tick Tick of the first record, as printed by dump_recording()
+ * \param	const record_t *loaded The records, oldest first
+ * \param	uint16_t loaded_count Number of records. Only the newest RECORDER_DEPTH are kept
+ * \return	N/A
+ * \brief   Replace the recording with one that was dumped, so it can be replayed off the board
+ */
+void load_recording(uint32_t first_tick, const record_t *loaded, uint16_t loaded_count);
+
+/**
+ * \fn		uint32_t replay_recording
+ * \param	trafficlight_t *tl The traffic light to replay into
+ * \param	led_output_t output Receives every LED update tl makes during the replay
+ * \return	Number of ticks replayed
+ * \brief   Rebuild tl from the oldest checkpoint in the recording and run the unmodified FSM over
+ * 			the recorded touch samples, as fast as possible, up to the current ticks_since_startup.
+ * 			Each tick runs update_fsm() on the tick's REC_TOUCH, if any, then poll_touch() on each of
+ * 			its REC_TOUCH_LATE in recorded order, just as the live controller sampled them.
+ * 			Drives ticks_since_startup itself, so it must not run alongside the live controller
+ */
+uint32_t replay_recording(trafficlight_t *tl, led_output_t output);
+#endif
+
+#endif /* RECORDER_H_ */
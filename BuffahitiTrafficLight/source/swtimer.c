@@ -0,0 +1,180 @@
+/**
+ * \file    swtimer.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Function definitions for software timers on a hierarchical timer wheel
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * User-defined libraries
+ */
+#include "swtimer.h"
+#include "systick.h"
+
+/**
+ * \fn		void link_swtimer
+ * \param	swtimer_t **head The slot to add timer to
+ * \param	swtimer_t *timer The timer, which must not be in any slot
+ * \return	N/A
+ * \brief   Push timer onto the front of a slot. Order within a slot does not matter, since every
+ * 			timer in a lower slot expires on the same tick
+ */
+static void link_swtimer(swtimer_t **head, swtimer_t *timer)
+{
+	timer->next = *head;
+
+	if(timer->next != NULL){
+		timer->next->pprev = &timer->next;
+	}
+
+	*head = timer;
+	timer->pprev = head;
+}
+
+/**
+ * \fn		void place_swtimer
+ * \param	swtimer_wheel_t *wheel The wheel
+ * \param	swtimer_t *timer The timer, with its expiry set and not in any slot
+ * \return	N/A
+ * \brief   Put timer in the slot that comes round at or just before its expiry
+ */
+static void place_swtimer(swtimer_wheel_t *wheel, swtimer_t *timer)
+{
+	uint32_t delta = timer->expiry - wheel->now;
+
+	if(delta < SWTIMER_SLOTS){
+		link_swtimer(&wheel->lower[timer->expiry & SWTIMER_SLOT_MASK], timer);
+	}
+	else if(delta < SWTIMER_SPAN){
+		link_swtimer(&wheel->upper[(timer->expiry >> SWTIMER_SLOT_BITS) & SWTIMER_SLOT_MASK], timer);
+	}
+	else{
+		/**
+		 * Too far off for either level. Park it in the upper slot that comes round last, and it is
+		 * placed again from there
+		 */
+		link_swtimer(&wheel->upper[((wheel->now >> SWTIMER_SLOT_BITS) + SWTIMER_SLOT_MASK) & SWTIMER_SLOT_MASK], timer);
+	}
+}
+
+void init_swtimer_wheel(swtimer_wheel_t *wheel, uint32_t now)
+{
+	uint32_t slot;
+
+	for(slot = 0; slot < SWTIMER_SLOTS; slot++){
+		wheel->lower[slot] = NULL;
+		wheel->upper[slot] = NULL;
+	}
+
+	wheel->now = now;
+}
+
+void init_swtimer(swtimer_t *timer, swtimer_callback_t callback, void *arg)
+{
+	timer->next = NULL;
+	timer->pprev = NULL;
+	timer->callback = callback;
+	timer->arg = arg;
+	timer->expiry = 0;
+}
+
+void start_swtimer(swtimer_wheel_t *wheel, swtimer_t *timer, uint32_t expiry)
+{
+	cancel_swtimer(timer);
+
+    /**
+     * The wheel has already handled the tick it is at, so the soonest a timer can expire is the next
+     */
+	timer->expiry = TICKS_REACHED(wheel->now, expiry) ? (wheel->now + 1) : expiry;
+	place_swtimer(wheel, timer);
+}
+
+void cancel_swtimer(swtimer_t *timer)
+{
+	if(timer->pprev != NULL){
+		*timer->pprev = timer->next;
+
+		if(timer->next != NULL){
+			timer->next->pprev = timer->pprev;
+		}
+
+		timer->next = NULL;
+		timer->pprev = NULL;
+	}
+}
+
+bool swtimer_due(const swtimer_wheel_t *wheel, const swtimer_t *timer)
+{
+	return ((timer->pprev != NULL) && (timer->expiry == wheel->now));
+}
+
+bool swtimer_expires_by(const swtimer_t *timer, uint32_t tick)
+{
+	return ((timer->pprev != NULL) && TICKS_REACHED(tick, timer->expiry));
+}
+
+uint32_t swtimer_quiet_ticks(const swtimer_wheel_t *wheel)
+{
+	uint32_t return_value;
+	uint32_t tick;
+
+    /**
+     * Every timer in the lower level expires within SWTIMER_SLOTS - 1 ticks, and nothing moves down
+     * from the upper level before the lower one comes round
+     */
+	for(return_value = 1; return_value < SWTIMER_SLOTS; return_value++){
+		tick = wheel->now + return_value;
+
+		if(wheel->lower[tick & SWTIMER_SLOT_MASK] != NULL){
+			break;
+		}
+
+		if(((tick & SWTIMER_SLOT_MASK) == 0) &&
+			(wheel->upper[(tick >> SWTIMER_SLOT_BITS) & SWTIMER_SLOT_MASK] != NULL)){
+			break;
+		}
+	}
+
+	return (return_value);
+}
+
+void advance_swtimers(swtimer_wheel_t *wheel, uint32_t now)
+{
+	swtimer_t *timer;
+	swtimer_t *next;
+	uint32_t slot;
+
+	while(wheel->now != now){
+		wheel->now++;
+		slot = wheel->now & SWTIMER_SLOT_MASK;
+
+	    /**
+	     * The lower level has come round, so move the upper slot for the next SWTIMER_SLOTS ticks
+	     * down into it (or park again whatever is still too far off)
+	     */
+		if(slot == 0){
+			timer = wheel->upper[(wheel->now >> SWTIMER_SLOT_BITS) & SWTIMER_SLOT_MASK];
+			wheel->upper[(wheel->now >> SWTIMER_SLOT_BITS) & SWTIMER_SLOT_MASK] = NULL;
+
+			while(timer != NULL){
+				next = timer->next;
+				place_swtimer(wheel, timer);
+				timer = next;
+			}
+		}
+
+	    /**
+	     * Everything left in this slot expires now. Unlink each timer before calling it, and take
+	     * them one at a time from the front, so a callback can start or cancel any timer (itself
+	     * included) without upsetting the walk
+	     */
+		while((timer = wheel->lower[slot]) != NULL){
+			cancel_swtimer(timer);
+			timer->callback(timer->arg);
+		}
+	}
+}
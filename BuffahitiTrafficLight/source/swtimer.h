@@ -0,0 +1,162 @@
+/**
+ * \file    swtimer.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Macros and function headers for software timers on a hierarchical timer wheel
+ */
+
+#ifndef SWTIMER_H_
+#define SWTIMER_H_
+
+/**
+ * \def		SWTIMER_SLOT_BITS
+ * \brief	Each level of the wheel has 2^SWTIMER_SLOT_BITS slots
+ */
+#define SWTIMER_SLOT_BITS\
+	(6)
+
+/**
+ * \def		SWTIMER_SLOTS
+ * \brief	Slots in each level of the wheel
+ */
+#define SWTIMER_SLOTS\
+	(1UL << SWTIMER_SLOT_BITS)
+
+/**
+ * \def		SWTIMER_SLOT_MASK
+ * \brief	Masks a tick down to its slot in a level
+ */
+#define SWTIMER_SLOT_MASK\
+	(SWTIMER_SLOTS - 1)
+
+/**
+ * \def		SWTIMER_SPAN
+ * \brief	Longest delay in ticks the two levels hold directly. Longer timers park in the last slot
+ * 			of the upper level and are placed again when it comes round (about 256 sec at TICK_HZ)
+ */
+#define SWTIMER_SPAN\
+	(SWTIMER_SLOTS * SWTIMER_SLOTS)
+
+/**
+ * \typedef	swtimer_callback_t
+ * \brief	Called when a timer expires, with the arg it was started with
+ */
+typedef void (*swtimer_callback_t)(void *arg);
+
+/**
+ * \typedef	swtimer_t
+ * \brief	To allow objects of struct swtimer_s to be declared with ease
+ */
+typedef struct swtimer_s swtimer_t;
+
+/**
+ * \typedef	swtimer_wheel_t
+ * \brief	To allow objects of struct swtimer_wheel_s to be declared with ease
+ */
+typedef struct swtimer_wheel_s swtimer_wheel_t;
+
+/**
+ * \struct	swtimer_s
+ * \brief	One timer. Lives inside whatever owns it, so the only RAM the service needs is the
+ * 			timers themselves and the wheel's slots. pprev points at whatever points at this timer,
+ * 			so it unlinks in O(1), and is NULL while the timer is stopped
+ */
+struct swtimer_s {
+	swtimer_t *next;
+	swtimer_t **pprev;
+	swtimer_callback_t callback;
+	void *arg;
+	uint32_t expiry;
+};
+
+/**
+ * \struct	swtimer_wheel_s
+ * \brief	Two levels of slots. The lower level holds timers due in the next SWTIMER_SLOTS ticks, one
+ * 			tick per slot. The upper holds the rest, SWTIMER_SLOTS ticks per slot, and each upper slot
+ * 			is moved down as the lower level comes round to it. now is the last tick advanced to
+ */
+struct swtimer_wheel_s {
+	swtimer_t *lower[SWTIMER_SLOTS];
+	swtimer_t *upper[SWTIMER_SLOTS];
+	uint32_t now;
+};
+
+/**
+ * \fn		void init_swtimer_wheel
+ * \param	swtimer_wheel_t *wheel The wheel to initialize
+ * \param	uint32_t now The current tick
+ * \return	N/A
+ * \brief   Empty wheel, starting from now
+ */
+void init_swtimer_wheel(swtimer_wheel_t *wheel, uint32_t now);
+
+/**
+ * \fn		void init_swtimer
+ * \param	swtimer_t *timer The timer to initialize
+ * \param	swtimer_callback_t callback What to call when timer expires
+ * \param	void *arg What to pass to callback
+ * \return	N/A
+ * \brief   Set up a stopped timer. Call once before any other swtimer function uses it
+ */
+void init_swtimer(swtimer_t *timer, swtimer_callback_t callback, void *arg);
+
+/**
+ * \fn		void start_swtimer
+ * \param	swtimer_wheel_t *wheel The wheel to run timer on
+ * \param	swtimer_t *timer The timer
+ * \param	uint32_t expiry The tick timer expires on, e.g. ticks_since_startup plus a delay. If the
+ * 			wheel is already at or past it, timer expires on the next tick the wheel advances to
+ * \return	N/A
+ * \brief   Start timer, or restart it if it is already running. Takes an absolute tick so a timer
+ * 			started before the wheel has been advanced to the current tick still expires on time. O(1)
+ */
+void start_swtimer(swtimer_wheel_t *wheel, swtimer_t *timer, uint32_t expiry);
+
+/**
+ * \fn		void cancel_swtimer
+ * \param	swtimer_t *timer The timer
+ * \return	N/A
+ * \brief   Stop timer without calling its callback. Does nothing if it is not running. O(1)
+ */
+void cancel_swtimer(swtimer_t *timer);
+
+/**
+ * \fn		bool swtimer_due
+ * \param	const swtimer_wheel_t *wheel The wheel timer runs on
+ * \param	const swtimer_t *timer The timer
+ * \return	True if timer is running and expires on the tick the wheel is at
+ * \brief   For callbacks that must give way to another timer expiring on the same tick
+ */
+bool swtimer_due(const swtimer_wheel_t *wheel, const swtimer_t *timer);
+
+/**
+ * \fn		bool swtimer_expires_by
+ * \param	const swtimer_t *timer The timer
+ * \param	uint32_t tick A tick at or after the one its wheel is at
+ * \return	True if timer is running and expires on or before tick
+ * \brief   For looking ahead at what advancing the wheel to tick will do
+ */
+bool swtimer_expires_by(const swtimer_t *timer, uint32_t tick);
+
+/**
+ * \fn		uint32_t swtimer_quiet_ticks
+ * \param	const swtimer_wheel_t *wheel The wheel
+ * \return	Ticks from the tick wheel is at to the next one on which advancing it has anything to do
+ * 			(expire a timer or move an upper slot down), up to SWTIMER_SLOTS
+ * \brief   How long the wheel can be left alone, e.g. to sleep through. Looks at each lower slot
+ * 			at most once, so it costs at most SWTIMER_SLOTS loads
+ */
+uint32_t swtimer_quiet_ticks(const swtimer_wheel_t *wheel);
+
+/**
+ * \fn		void advance_swtimers
+ * \param	swtimer_wheel_t *wheel The wheel
+ * \param	uint32_t now The current tick
+ * \return	N/A
+ * \brief   Move the wheel on to now one tick at a time, calling the callback of every timer that
+ * 			expires on the way. Callbacks may start and cancel any timer. Does nothing if the wheel
+ * 			is already at now. O(1) per tick plus O(1) per timer expired or moved down
+ */
+void advance_swtimers(swtimer_wheel_t *wheel, uint32_t now);
+
+#endif /* SWTIMER_H_ */
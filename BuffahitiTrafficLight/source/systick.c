@@ -16,6 +16,7 @@
  * User-defined libraries
  */
 #include "bitops.h"
+#include "event.h"
 #include "fsm_trafficlight.h"
 #include "led.h"
 #include "systick.h"
@@ -23,52 +24,117 @@
 
 /**
  * \var		ticktime_t ticks_since_startup
- * \brief	Ticks since boot, where each tick is 62.5 ms
+ * \brief	Ticks since boot that the main loop has processed, where each tick is 62.5 ms. Only
+ * 			touched by the main loop
  */
-volatile ticktime_t ticks_since_startup = 0;
+ticktime_t ticks_since_startup = 0;
 
 /**
- * \var		volatile ticktime_t ticks_spent_transitioning
- * \brief	Ticks spent transitioning to current state, where each tick is 62.5 ms
+ * \var		ticktime_t ticks_elapsed
+ * \brief	Ticks since boot that SysTick_Handler() and systick_skip() have raised. Each EVENT_TICK
+ * 			carries it, so the main loop catches up to it one tick at a time and a slow loop
+ * 			iteration (or a dropped event) delays ticks rather than losing them. Only touched at
+ * 			EVENT_IRQ_PRIORITY or with interrupts masked
  */
-volatile ticktime_t ticks_spent_transitioning = 0;
+static ticktime_t ticks_elapsed = 0;
 
 /**
- * \var		volatile ticktime_t ticks_spent_stable
- * \brief	Ticks spent in current state (not including transition period), where each tick is 62.5 ms
+ * \var		volatile uint64_t systick_wraps
+ * \brief	Number of times the SysTick counter has reloaded. Unlike ticks_since_startup it is
+ * 			counted in the ISR, so it never lags the counter by more than the ISR's latency. Only
+ * 			written by SysTick_Handler() and, with interrupts masked, systick_skip()
  */
-volatile ticktime_t ticks_spent_stable = 0;
+volatile uint64_t systick_wraps = 0;
 
 /**
- * \var		volatile ticktime_t ticks_spent_crosswalk_on
- * \brief	Ticks spent with LED on for current blink in CROSSWALK state, where each tick is 62.5 ms
+ * \var		uint64_t systick_base
+ * \brief	SysTick counts from startup to the start of the running period. Only written by
+ * 			SysTick_Handler() and, with interrupts masked, systick_skip()
  */
-volatile ticktime_t ticks_spent_crosswalk_on = 0;
+static volatile uint64_t systick_base = 0;
 
 /**
- * \var		volatile ticktime_t ticks_spent_crosswalk_off
- * \brief	Ticks spent with LED off for current blink in CROSSWALK state, where each tick is 62.5 ms
+ * \var		uint32_t systick_period
+ * \brief	Length in counts of the running period
  */
-volatile ticktime_t ticks_spent_crosswalk_off = 0;
+static volatile uint32_t systick_period = SYSTICK_PERIOD_COUNTS;
 
 /**
- * \var		volatile bool tick
- * \brief	Flag controlled by SysTick timer
+ * \var		uint32_t systick_next_period
+ * \brief	Length in counts of the next period, already written to SysTick->LOAD
  */
-volatile bool tick = false;
+static volatile uint32_t systick_next_period = SYSTICK_PERIOD_COUNTS;
+
+/**
+ * \var		uint32_t systick_skipped
+ * \brief	Counts handed to systick_skip() that have not made up a whole period yet
+ */
+static uint32_t systick_skipped = 0;
+
+/**
+ * \var		uint32_t systick_scale
+ * \brief	SysTick counts per count of the counter, which is more than 1 while the core clock is
+ * 			slowed down (e.g. SYSTICK_VLPR_SCALE)
+ */
+static volatile uint32_t systick_scale = 1;
+
+/**
+ * \var		uint64_t systick_cycles_base
+ * \brief	Core cycles run from startup to systick_scale_since, each span at the core clock of its
+ * 			mode. Only written by systick_pause() and systick_resume(), with interrupts masked
+ */
+static volatile uint64_t systick_cycles_base = 0;
+
+/**
+ * \var		uint64_t systick_scale_since
+ * \brief	uptime_counts() when systick_scale took effect
+ */
+static volatile uint64_t systick_scale_since = 0;
+
+/**
+ * \var		uint32_t systick_remaining
+ * \brief	Counts left in the running period when systick_pause() froze the counter
+ */
+static uint32_t systick_remaining = 0;
+
+/**
+ * \var		uint32_t systick_error
+ * \brief	How far the periods planned so far fall short of as many exact 1 / TICK_HZ sec ones, in
+ * 			units of 1 / TICK_HZ count. The first two periods are planned by
+ * 			init_onboard_systick(), both of SYSTICK_PERIOD_COUNTS
+ */
+static uint32_t systick_error = 2 * SYSTICK_PERIOD_REMAINDER;
+
+/**
+ * \fn		void plan_next_period
+ * \param	N/A
+ * \return	N/A
+ * \brief   Make the next period as much of systick_error as whole counts of the counter allow and
+ * 			write it to LOAD, which only takes effect at the next reload. What is left over is
+ * 			carried to the periods after it, so the tick rate has no long-run error at any clock
+ */
+static void plan_next_period(void)
+{
+	uint32_t load = systick_error / (TICK_HZ * systick_scale);
+
+	systick_next_period = load * systick_scale;
+	systick_error -= systick_next_period * TICK_HZ;
+
+	SysTick->LOAD = load - 1;
+}
 
 void init_onboard_systick(void)
 {
     /**
      * Configure the SysTick LOAD register:
-     * 	- To generate interrupt every TICK_SEC
+     * 	- To generate interrupt every 1 / TICK_HZ sec
      */
-	SysTick->LOAD = ((ALT_CLOCK_HZ - 1) * TICK_SEC);
+	SysTick->LOAD = SYSTICK_LOAD;
 
 	/**
      * Set the SysTick interrupt priority (range 0 to 3, with 0 being highest priority)
      */
-	NVIC_SetPriority(SysTick_IRQn, 3);
+	NVIC_SetPriority(SysTick_IRQn, EVENT_IRQ_PRIORITY);
 
 	/**
      * Configure SysTick VAL register:
@@ -94,15 +160,250 @@ void init_onboard_systick(void)
 void SysTick_Handler(void)
 {
     /**
-     * Raise flag that TICK_SEC time has passed
+     * The counter just reloaded with systick_next_period, so that period is now running
+     */
+	systick_base += systick_period;
+	systick_period = systick_next_period;
+
+    /**
+     * Plan the period after it. SYSTICK_PERIOD_REMAINDER and any counts the counter's clock can't
+     * divide are spread out the same way a line is drawn
+     */
+	systick_error += ALT_CLOCK_HZ;
+	plan_next_period();
+
+    /**
+     * Count that 1 / TICK_HZ sec has passed and tell the main loop, which catches up on every tick
+     * counted
+     */
+	ticks_elapsed++;
+	(void)event_publish(EVENT_TICK, ticks_elapsed);
+
+	systick_wraps++;
+}
+
+ticktime_t systick_skip(uint32_t counts)
+{
+	ticktime_t return_value = 0;
+
+	systick_skipped += counts;
+
+    /**
+     * The running period (and the LOAD already written for the next) is left alone, since the
+     * counter is still partway through it
+     */
+	while(systick_skipped >= systick_period){
+		systick_skipped -= systick_period;
+		systick_base += systick_period;
+		systick_wraps++;
+		ticks_elapsed++;
+		return_value++;
+	}
+
+	if(return_value > 0){
+		(void)event_publish(EVENT_TICK, ticks_elapsed);
+	}
+
+	return (return_value);
+}
+
+uint32_t systick_lag(void)
+{
+	return (systick_skipped);
+}
+
+void systick_pause(void)
+{
+	uint32_t val;
+
+	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+	val = SysTick->VAL;
+
+    /**
+     * The counter restarts from a fresh LOAD, so a reload it has already raised is counted now
+     * rather than by the pending interrupt
+     */
+	if(SCB->ICSR & SCB_ICSR_PENDSTSET_Msk){
+		SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+		SysTick_Handler();
+	}
+
+    /**
+     * A counter at 0 is on the boundary, so the whole of the period just counted is left
+     */
+	systick_remaining = (val == 0) ? systick_period : (val * systick_scale);
+
+    /**
+     * The core stops counting cycles at the old clock here. Counts from now until
+     * systick_resume() (the clock switch or a stop) run no known number of cycles
+     */
+	systick_cycles_base += systick_cycles(uptime_counts() - systick_scale_since);
+}
+
+ticktime_t systick_resume(uint32_t scale, uint32_t stopped_counts)
+{
+	ticktime_t stopped;
+	uint32_t load;
+
+	systick_scale = scale;
+
+    /**
+     * Finish the paused period at the new clock. Rounding down to its counts shortens the period
+     * by less than one of them, and LOAD must be at least 1. The running period is counted as
+     * however long that makes it, and the periods after it make up the difference
+     */
+	load = systick_remaining / scale;
+
+	if(load < 2){
+		load = 2;
+	}
+
+	systick_period = systick_period - systick_remaining + (load * scale);
+	systick_error += (systick_remaining - (load * scale)) * TICK_HZ;
+
+	SysTick->LOAD = load - 1;
+	SysTick->VAL = 0;
+	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    /**
+     * The first count at the new clock reloads the counter from LOAD. Only after that can LOAD
+     * be given the length of the periods that follow, planned again in whole counts of the new
+     * clock
      */
-	tick = true;
+	while(SysTick->VAL == 0){
+	}
+
+	systick_error += systick_next_period * TICK_HZ;
+	plan_next_period();
+
+	stopped = systick_skip(stopped_counts);
+	systick_scale_since = uptime_counts();
+
+	return (stopped);
+}
+
+/**
+ * \fn		void read_uptime
+ * \param	uint64_t *wraps Receives the number of reloads
+ * \param	uint64_t *base Receives the SysTick counts from startup to the last reload
+ * \param	uint32_t *counts Receives the SysTick counts since the last reload
+ * \return	N/A
+ * \brief   Read the reload count and the counter as one consistent pair
+ */
+static void read_uptime(uint64_t *wraps, uint64_t *base, uint32_t *counts)
+{
+	uint64_t wraps_seen;
+	uint64_t base_seen;
+	uint32_t period;
+	uint32_t scale;
+	uint32_t val;
+	bool reloaded;
+
+    /**
+     * Retry if SysTick_Handler() ran in between, since then the counter may belong to the next
+     * tick. It also catches a 64-bit load torn by the handler
+     */
+	do{
+		wraps_seen = systick_wraps;
+		base_seen = systick_base;
+		period = systick_period;
+		scale = systick_scale;
+		val = SysTick->VAL;
+		reloaded = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+	}while(wraps_seen != systick_wraps);
+
+    /**
+     * The counter reached 0 but SysTick_Handler() has not counted it yet, because interrupts are
+     * masked or this is an interrupt SysTick can't preempt. val may be from either side of that,
+     * but it happened before PENDSTSET was read, so a fresh load is after it
+     */
+	if(reloaded){
+		val = SysTick->VAL;
+		wraps_seen++;
+		base_seen += period;
+		period = systick_next_period;
+	}
+
+	*wraps = wraps_seen;
+	*base = base_seen;
+
+    /**
+     * SysTick counts down, scale counts at a time, and raises its interrupt on reaching 0 rather
+     * than on reloading. So 0 is the start of the next period, which wraps and base already
+     * include once the interrupt has been taken or seen pending
+     */
+	*counts = (val == 0) ? 0 : (period - (val * scale));
+}
+
+uint64_t uptime_counts(void)
+{
+	uint64_t wraps;
+	uint64_t base;
+	uint32_t counts;
+
+	read_uptime(&wraps, &base, &counts);
+
+	return (base + counts);
+}
+
+uint64_t uptime_cycles(void)
+{
+	return (systick_cycles_base + systick_cycles(uptime_counts() - systick_scale_since));
+}
+
+uint64_t systick_cycles(uint64_t counts)
+{
+    /**
+     * The SysTick counter always counts every CYCLES_PER_SYSTICK_COUNT core cycles, and each of its
+     * counts is systick_scale SysTick counts
+     */
+	return ((counts * CYCLES_PER_SYSTICK_COUNT) / systick_scale);
+}
+
+uint64_t uptime_usec(void)
+{
+	uint64_t wraps;
+	uint64_t base;
+	uint32_t counts;
+
+	read_uptime(&wraps, &base, &counts);
+
+    /**
+     * Not wraps * USEC_PER_TICK, since periods are not all the same length
+     */
+	return ((base + counts) / COUNTS_PER_USEC);
+}
+
+uint32_t systick_counts(void)
+{
+	uint64_t wraps;
+	uint64_t base;
+	uint32_t counts;
+
+	read_uptime(&wraps, &base, &counts);
+
+	return ((uint32_t)base + counts);
 }
 
 volatile uint32_t now(void)
+{
+	uint64_t wraps;
+	uint64_t base;
+	uint32_t counts;
+
+	read_uptime(&wraps, &base, &counts);
+
+    /**
+     * Not ticks_to_msec(wraps), since periods are not all the same length
+     */
+	return ((uint32_t)((base + counts) / COUNTS_PER_MSEC));
+}
+
+uint32_t ticks_to_msec(ticktime_t ticks)
 {
     /**
-     * Convert ticks to sec, and then sec to ms
+     * Convert whole sec and the leftover ticks to ms separately so ticks * MSEC_PER_SEC can't
+     * overflow. TICK_HZ is a power of 2, so the division and modulo reduce to shift and mask
      */
-	return((ticks_since_startup * TICK_SEC * MSEC_PER_SEC));
+	return(((ticks / TICK_HZ) * MSEC_PER_SEC) + (((ticks % TICK_HZ) * MSEC_PER_SEC) / TICK_HZ));
 }
@@ -41,17 +41,98 @@
 
 /**
  * \def		TICK_HZ
- * \brief	The frequency at which SysTick interrupts should be raised in Hz
+ * \brief	The frequency at which SysTick interrupts should be raised in Hz. Need not divide
+ * 			ALT_CLOCK_HZ, see SYSTICK_PERIOD_REMAINDER
  */
+#ifndef TICK_HZ
 #define TICK_HZ\
 	(16)
+#endif
+
+/**
+ * \def		SYSTICK_PERIOD_COUNTS
+ * \brief	Whole SysTick counts in 1 / TICK_HZ sec. Integer math only, so this is resolved at
+ * 			compile time
+ */
+#define SYSTICK_PERIOD_COUNTS\
+	(ALT_CLOCK_HZ / TICK_HZ)
 
 /**
- * \def		TICK_SEC
- * \brief	The period between SysTick interrupts in sec
+ * \def		SYSTICK_PERIOD_REMAINDER
+ * \brief	Counts left over when ALT_CLOCK_HZ doesn't divide evenly into ticks. Spread over every
+ * 			TICK_HZ ticks by SysTick_Handler(), so the average tick is exactly 1 / TICK_HZ sec
  */
-#define TICK_SEC\
-	(1.0/TICK_HZ)
+#define SYSTICK_PERIOD_REMAINDER\
+	(ALT_CLOCK_HZ % TICK_HZ)
+
+/**
+ * \def		SYSTICK_LOAD
+ * \brief	The value to load into SysTick->LOAD so that an interrupt is raised every
+ * 			SYSTICK_PERIOD_COUNTS counts
+ */
+#define SYSTICK_LOAD\
+	(SYSTICK_PERIOD_COUNTS - 1)
+
+/**
+ * \def		CYCLES_PER_SYSTICK_COUNT
+ * \brief	SysTick runs from the external reference (core clock / 16), so each count of
+ * 			SysTick->VAL is this many core cycles. At PRIM_CLOCK_HZ that is also the number of
+ * 			cycles per SysTick count, but not in VLPR, see systick_cycles()
+ */
+#define CYCLES_PER_SYSTICK_COUNT\
+	(PRIM_CLOCK_HZ / ALT_CLOCK_HZ)
+
+/**
+ * \def		COUNTS_PER_USEC
+ * \brief	SysTick counts per usec
+ */
+#define COUNTS_PER_USEC\
+	((uint32_t)(ALT_CLOCK_HZ / 1000000UL))
+
+/**
+ * \def		COUNTS_PER_MSEC
+ * \brief	SysTick counts per msec
+ */
+#define COUNTS_PER_MSEC\
+	(ALT_CLOCK_HZ / MSEC_PER_SEC)
+
+/**
+ * \def		USEC_PER_TICK
+ * \brief	Length of a tick in usec, rounded down unless TICK_HZ divides 1000000
+ */
+#define USEC_PER_TICK\
+	(1000000UL / TICK_HZ)
+
+/**
+ * \def		VLPR_ALT_CLOCK_HZ
+ * \brief	Frequency of the alternate clock source in Hz in VLPR, where the core runs at 4 MHz
+ */
+#define VLPR_ALT_CLOCK_HZ\
+	(4000000UL / 16)
+
+/**
+ * \def		SYSTICK_VLPR_SCALE
+ * \brief	SysTick counts (1 / ALT_CLOCK_HZ sec) per count of the SysTick counter in VLPR. Every
+ * 			time in this module stays in 1 / ALT_CLOCK_HZ counts whichever mode the CPU runs in
+ */
+#define SYSTICK_VLPR_SCALE\
+	(ALT_CLOCK_HZ / VLPR_ALT_CLOCK_HZ)
+
+/**
+ * \def		SEC_TO_TICKS(sec)
+ * \param	sec	The duration in sec to convert
+ * \brief	Convert a duration in sec to a whole number of ticks at compile time
+ */
+#define SEC_TO_TICKS(sec)\
+	((sec) * TICK_HZ)
+
+/**
+ * \def		MSEC_TO_TICKS(msec)
+ * \param	msec The duration in msec to convert
+ * \brief	Convert a duration in msec to a whole number of ticks at compile time (rounded down)
+ */
+#define MSEC_TO_TICKS(msec)\
+	(((msec) * TICK_HZ) / MSEC_PER_SEC)
 
 #ifdef DEBUG
 /**
@@ -154,47 +235,54 @@
 #endif
 
 /**
- * \typedef	typedef unsigned int ticktime_t
- * \brief   Time since boot, where each tick is 1 / ALT_CLOCK_HZ or 1 / PRIM_CLOCK_HZ, depending
- * 			on what's configured
+ * \def		TICKS_PER_CROSSWALK_ON
+ * \brief	MSEC_PER_CROSSWALK_ON expressed in ticks
  */
-typedef unsigned int ticktime_t;
+#define TICKS_PER_CROSSWALK_ON\
+	(MSEC_TO_TICKS(MSEC_PER_CROSSWALK_ON))
 
 /**
- * \var		ticktime_t ticks_since_startup
- * \brief	Defined in systick.c
+ * \def		TICKS_PER_CROSSWALK_OFF
+ * \brief	MSEC_PER_CROSSWALK_OFF expressed in ticks
  */
-extern volatile ticktime_t ticks_since_startup;
+#define TICKS_PER_CROSSWALK_OFF\
+	(MSEC_TO_TICKS(MSEC_PER_CROSSWALK_OFF))
 
 /**
- * \var		extern volatile ticktime_t ticks_spent_stable
- * \brief	Defined in systick.c
+ * \def		TICKS_PER_TRANSITION
+ * \brief	SEC_PER_TRANSITION expressed in ticks
  */
-extern volatile ticktime_t ticks_spent_stable;
+#define TICKS_PER_TRANSITION\
+	(SEC_TO_TICKS(SEC_PER_TRANSITION))
 
 /**
- * \var		extern volatile ticktime_t ticks_spent_transitioning
- * \brief	Defined in systick.c
+ * \typedef	typedef unsigned int ticktime_t
+ * \brief   Time since boot, where each tick is 1 / ALT_CLOCK_HZ or 1 / PRIM_CLOCK_HZ, depending
+ * 			on what's configured
  */
-extern volatile ticktime_t ticks_spent_transitioning;
+typedef unsigned int ticktime_t;
 
 /**
- * \var		extern volatile ticktime_t ticks_spent_crosswalk_on
- * \brief	Defined in systick.c
+ * \def		TICKS_REACHED(now, deadline)
+ * \param	now			The current tick
+ * \param	deadline	The tick to compare against
+ * \brief	True once now is at or past deadline. Compares the signed difference so it keeps
+ * 			working when ticks_since_startup wraps
  */
-extern volatile ticktime_t ticks_spent_crosswalk_on;
+#define TICKS_REACHED(now, deadline)\
+	((int32_t)((ticktime_t)(now) - (ticktime_t)(deadline)) >= 0)
 
 /**
- * \var		extern volatile ticktime_t ticks_spent_crosswalk_off
+ * \var		ticktime_t ticks_since_startup
  * \brief	Defined in systick.c
  */
-extern volatile ticktime_t ticks_spent_crosswalk_off;
+extern ticktime_t ticks_since_startup;
 
 /**
- * \var		extern volatile bool tick
+ * \var		extern volatile uint64_t systick_wraps
  * \brief	Defined in systick.c
  */
-extern volatile bool tick;
+extern volatile uint64_t systick_wraps;
 
 /**
  * \fn		void init_onboard_systick
@@ -208,20 +296,113 @@ void init_onboard_systick(void);
  * \fn		void SysTick_Handler
  * \param	N/A
  * \return	N/A
- * \brief   The ISR for the SysTick timer (i.e. runs each time the timer reaches 0).
+ * \brief   The ISR for the SysTick timer (i.e. runs each time the timer reaches 0). Publishes an
+ * 			EVENT_TICK for each tick
  * \detail	FUNCTION NAME IS CASE SENSITIVE. Since it is weakly defined in
  * 			startup\startup_mkl25z4.c this definition will override
  */
 void SysTick_Handler(void);
 
+/**
+ * \fn		ticktime_t systick_skip
+ * \param	uint32_t counts SysTick counts that passed while the SysTick clock was stopped
+ * \return	Number of ticks raised for them
+ * \brief   Stop modes freeze SysTick, so the time spent in one is measured elsewhere and handed
+ * 			in here on wakeup. Whole periods are counted as ticks, exactly as SysTick_Handler()
+ * 			would have, with one EVENT_TICK for them all, and the rest is carried over to the next
+ * 			call. The counter itself is left where it froze, so ticks run up to one period behind
+ * 			real time but never lose any. Call with interrupts masked
+ */
+ticktime_t systick_skip(uint32_t counts);
+
+/**
+ * \fn		uint32_t systick_lag
+ * \param	N/A
+ * \return	SysTick counts carried over by systick_skip(), i.e. how far ticks are behind real time
+ * \brief   Lets a caller sleep just short of a whole number of ticks
+ */
+uint32_t systick_lag(void);
+
+/**
+ * \fn		void systick_pause
+ * \param	N/A
+ * \return	N/A
+ * \brief   Freeze the SysTick counter before its clock changes, counting a reload that is still
+ * 			pending. Call with interrupts masked, then systick_resume() once the clock is stable
+ */
+void systick_pause(void);
+
+/**
+ * \fn		ticktime_t systick_resume
+ * \param	uint32_t scale SysTick counts per count of the counter at the new clock, i.e. 1 at
+ * 			ALT_CLOCK_HZ or SYSTICK_VLPR_SCALE in VLPR
+ * \param	uint32_t stopped_counts SysTick counts that passed while the counter was paused
+ * \return	Number of ticks raised for stopped_counts, as by systick_skip()
+ * \brief   Restart the counter at the new clock. The paused period is finished first, with LOAD
+ * 			recomputed for the new clock, so every later period is still 1 / TICK_HZ sec
+ */
+ticktime_t systick_resume(uint32_t scale, uint32_t stopped_counts);
+
+/**
+ * \fn		uint64_t uptime_counts
+ * \param	N/A
+ * \return	Time since startup in SysTick counts (1 / ALT_CLOCK_HZ sec each)
+ * \brief   Monotonic clock made of the reloads counted by SysTick_Handler() and the live
+ * 			SysTick->VAL. Safe to call from any context, including with interrupts masked or from an
+ * 			interrupt that SysTick can't preempt, as long as that lasts less than a tick
+ */
+uint64_t uptime_counts(void);
+
+/**
+ * \fn		uint64_t uptime_cycles
+ * \param	N/A
+ * \return	Core clock cycles run since startup, to a resolution of CYCLES_PER_SYSTICK_COUNT
+ * \brief   See uptime_counts(). Each stretch counts at the core clock it ran at, 48 MHz in RUN and
+ * 			4 MHz in VLPR. The time spent stopped or switching clocks runs no cycles
+ */
+uint64_t uptime_cycles(void);
+
+/**
+ * \fn		uint64_t systick_cycles
+ * \param	uint64_t counts A duration in SysTick counts, spent at the current core clock
+ * \return	The core cycles it took
+ * \brief   For timing code in cycles whichever mode it ran in
+ */
+uint64_t systick_cycles(uint64_t counts);
+
+/**
+ * \fn		uint64_t uptime_usec
+ * \param	N/A
+ * \return	Time since startup in usec
+ * \brief   See uptime_counts()
+ */
+uint64_t uptime_usec(void);
+
+/**
+ * \fn		uint32_t systick_counts
+ * \param	N/A
+ * \return	The low 32 bits of uptime_counts()
+ * \brief   A cheaper timestamp for measuring intervals. Differences of two values are exact as
+ * 			long as they are less than 2^32 counts (about 23 min) apart
+ */
+uint32_t systick_counts(void);
+
 /**
  * \fn		uint32_t now
  * \param	N/A
  * \return	Time since startup in ms
- * \brief   Returns time since startup, in ms
+ * \brief   Returns time since startup, in ms. Wraps after about 49 days
  */
 volatile uint32_t now(void);
 
+/**
+ * \fn		uint32_t ticks_to_msec
+ * \param	ticktime_t ticks A tick count, e.g. a value of ticks_since_startup
+ * \return	ticks in ms
+ * \brief   Converts ticks to ms using integer math only
+ */
+uint32_t ticks_to_msec(ticktime_t ticks);
+
 /**
  * \fn		void reset_timer
  * \param	N/A
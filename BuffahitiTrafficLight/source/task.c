@@ -0,0 +1,175 @@
+/**
+ * \file    task.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Function definitions for the cooperative run-to-completion task scheduler
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "board.h"
+#include "fsl_debug_console.h"
+
+/**
+ * User-defined libraries
+ */
+#include "systick.h"
+#include "task.h"
+
+/**
+ * \typedef	task_t
+ * \brief	To allow objects of struct task_s to be declared with ease
+ */
+typedef struct task_s task_t;
+
+/**
+ * \struct	task_s
+ * \brief	One task slot: what it runs, when it is next due, and its timing since the last report,
+ * 			in SysTick counts
+ */
+struct task_s {
+	task_fn_t fn;
+	void *arg;
+	uint32_t period_ticks;
+	uint32_t due_tick;
+	uint32_t ready_stamp;
+	bool ready;
+	uint32_t runs;
+	uint32_t total_counts;
+	uint32_t max_counts;
+	uint32_t max_wait_counts;
+};
+
+/**
+ * \var		task_t tasks[NUM_TASKS]
+ * \brief	The task slots, indexed by task_id_t
+ */
+static task_t tasks[NUM_TASKS];
+
+/**
+ * \var		const char *task_names[NUM_TASKS]
+ * \brief	Names printed for each task
+ */
+static const char *const task_names[NUM_TASKS] = {
+	[TASK_FSM] = "fsm",
+	[TASK_TOUCH] = "touch",
+	[TASK_SCAN] = "scan",
+	[TASK_TRACE] = "trace",
+	[TASK_PROFILE] = "profile",
+	[TASK_CONSOLE] = "console"
+};
+
+void init_task(task_id_t id, task_fn_t fn, void *arg, uint32_t period_ticks, uint32_t now)
+{
+	task_t *task = &tasks[id];
+
+	task->fn = fn;
+	task->arg = arg;
+	task->period_ticks = period_ticks;
+	task->due_tick = now + period_ticks;
+	task->ready = false;
+}
+
+void task_trigger(task_id_t id)
+{
+	task_t *task = &tasks[id];
+
+    /**
+     * The wait is counted from the first trigger, since that one has waited longest
+     */
+	if((task->fn != NULL) && !task->ready){
+		task->ready = true;
+		task->ready_stamp = systick_counts();
+	}
+}
+
+void task_advance(uint32_t now)
+{
+	task_t *task;
+
+	for(task = tasks; task < &tasks[NUM_TASKS]; task++){
+		if((task->period_ticks == 0) || !TICKS_REACHED(now, task->due_tick)){
+			continue;
+		}
+
+		task_trigger(task - tasks);
+
+	    /**
+	     * Skip the periods that ended while the main loop was away, rather than running the task
+	     * once for each of them
+	     */
+		do{
+			task->due_tick += task->period_ticks;
+		}while(TICKS_REACHED(now, task->due_tick));
+	}
+}
+
+bool task_run_next(void)
+{
+	bool return_value = false;
+	task_t *task;
+	uint32_t start;
+	uint32_t counts;
+
+	for(task = tasks; task < &tasks[NUM_TASKS]; task++){
+		if(task->ready){
+			break;
+		}
+	}
+
+	if(task < &tasks[NUM_TASKS]){
+
+	    /**
+	     * Clear ready first, so a trigger while it runs (e.g. from the task itself) runs it again
+	     */
+		task->ready = false;
+
+		start = systick_counts();
+		task->fn(task->arg);
+		counts = systick_counts() - start;
+
+		task->runs++;
+		task->total_counts += counts;
+
+		if(counts > task->max_counts){
+			task->max_counts = counts;
+		}
+
+		if((start - task->ready_stamp) > task->max_wait_counts){
+			task->max_wait_counts = start - task->ready_stamp;
+		}
+
+		return_value = true;
+	}
+
+	return (return_value);
+}
+
+void task_report(void)
+{
+	task_id_t id;
+	task_t *task;
+
+	for(id = 0; id < NUM_TASKS; id++){
+		task = &tasks[id];
+
+		if(task->runs == 0){
+			continue;
+		}
+
+		PRINTF("task,%s,%u,%u,%u,%u\r\n",
+			task_names[id],
+			task->runs,
+			task->total_counts / task->runs / COUNTS_PER_USEC,
+			task->max_counts / COUNTS_PER_USEC,
+			task->max_wait_counts / COUNTS_PER_USEC);
+
+	    /**
+	     * Each report covers only the time since the previous one
+	     */
+		task->runs = 0;
+		task->total_counts = 0;
+		task->max_counts = 0;
+		task->max_wait_counts = 0;
+	}
+}
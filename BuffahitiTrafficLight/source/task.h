@@ -0,0 +1,95 @@
+/**
+ * \file    task.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Macros and function headers for the cooperative run-to-completion task scheduler
+ */
+
+#ifndef TASK_H_
+#define TASK_H_
+
+/**
+ * \def		TASK_REPORT_CMD
+ * \brief	Character that requests task_report() when received on the debug console
+ */
+#define TASK_REPORT_CMD\
+	('t')
+
+/**
+ * \typedef	task_fn_t
+ * \brief	A task's body. Runs to completion each time the task is ready, with the arg it was
+ * 			initialized with
+ */
+typedef void (*task_fn_t)(void *arg);
+
+/**
+ * \typedef	task_id_t
+ * \brief	To allow objects of enum task_id_e to be declared with ease
+ */
+typedef enum task_id_e task_id_t;
+
+/**
+ * \enum	task_id_e
+ * \brief	The fixed task slots, highest priority first. Whenever more than one task is ready, the
+ * 			first in this order runs
+ */
+enum task_id_e {
+	TASK_FSM,			/* Run the traffic light for each tick raised */
+	TASK_TOUCH,			/* Take a finished touch scan */
+	TASK_SCAN,			/* Arm the next touch scan */
+	TASK_TRACE,			/* Print queued trace events */
+	TASK_PROFILE,		/* Print what the hot path has cost */
+	TASK_CONSOLE,		/* Run a command from the debug console */
+	NUM_TASKS
+};
+
+/**
+ * \fn		void init_task
+ * \param	task_id_t id The slot to fill
+ * \param	task_fn_t fn The task's body
+ * \param	void *arg What to pass to fn
+ * \param	uint32_t period_ticks Ticks between runs, or 0 if the task only runs when triggered
+ * \param	uint32_t now The current tick, from which the first period is counted
+ * \return	N/A
+ * \brief   Set up a task. A slot that is never initialized never runs
+ */
+void init_task(task_id_t id, task_fn_t fn, void *arg, uint32_t period_ticks, uint32_t now);
+
+/**
+ * \fn		void task_trigger
+ * \param	task_id_t id The task
+ * \return	N/A
+ * \brief   Make a task ready. Triggering a task that is already ready does nothing, so it runs
+ * 			once for all of them. Main loop only
+ */
+void task_trigger(task_id_t id);
+
+/**
+ * \fn		void task_advance
+ * \param	uint32_t now The tick just processed
+ * \return	N/A
+ * \brief   Make every periodic task whose period has ended by now ready. Periods missed while the
+ * 			main loop was busy or asleep are run once, and the next period keeps its phase
+ */
+void task_advance(uint32_t now);
+
+/**
+ * \fn		bool task_run_next
+ * \param	N/A
+ * \return	Returns true if a task ran, false if none was ready
+ * \brief   Run the highest priority ready task to completion, and account the time it took and
+ * 			the time it waited since it was made ready
+ */
+bool task_run_next(void);
+
+/**
+ * \fn		void task_report
+ * \param	N/A
+ * \return	N/A
+ * \brief   Print each task that ran since the last report over the debug console:
+ * 			task,<name>,<runs>,<average usec>,<longest usec>,<longest wait usec>
+ * 			The longest wait of TASK_FSM bounds how long the other tasks delayed a tick
+ */
+void task_report(void);
+
+#endif /* TASK_H_ */
@@ -12,7 +12,214 @@
 /**
  * User-defined libraries
  */
+#include "event.h"
+#include "fsm_trafficlight.h"
+#include "lptmr.h"
+#include "profile.h"
+#include "recorder.h"
+#include "systick.h"
 #include "touch.h"
+#include "touch_filter.h"
+
+/**
+ * \var		uint32_t touch_reading
+ * \brief	Raw value of the latest scan handed to touch_scanned()
+ */
+static uint32_t touch_reading;
+
+/**
+ * \var		uint32_t touch_reading_stamp
+ * \brief	systick_counts() when the scan in touch_reading was published
+ */
+static uint32_t touch_reading_stamp;
+
+/**
+ * \var		bool touch_fresh
+ * \brief	True while get_touch() has not taken touch_reading yet
+ */
+static bool touch_fresh;
+
+/**
+ * \var		uint32_t touch_sample_stamp
+ * \brief	touch_reading_stamp of the latest sample run through the pipeline, if touch_stamped
+ */
+static uint32_t touch_sample_stamp;
+
+/**
+ * \var		bool touch_stamped
+ * \brief	True if the latest sample came from a published scan and its stamp has not been taken
+ */
+static bool touch_stamped;
+
+/**
+ * \var		touch_filter_t touch_filter
+ * \brief	Detection pipeline every sample goes through. Its baseline starts from
+ * 			calibrate_touch_sensor() and then follows drift in the untouched electrode
+ */
+static touch_filter_t touch_filter;
+
+/**
+ * \var		uint8_t touch_scan_shift
+ * \brief	How far scans are currently shortened, see TOUCH_SCAN_SHIFT_MAX
+ */
+static uint8_t touch_scan_shift;
+
+/**
+ * \var		uint8_t touch_settle
+ * \brief	Number of samples still to be ignored since the scan length changed
+ */
+static uint8_t touch_settle;
+
+/**
+ * \var		uint32_t touch_threshold_baseline
+ * \brief	The baseline the TSHD threshold was last set from
+ */
+static uint32_t touch_threshold_baseline;
+
+/**
+ * \fn		uint32_t scan_touch_blocking
+ * \param	N/A
+ * \return	The raw scanned value
+ * \brief   Software trigger a scan and wait for it. Only used before the TSI interrupt is enabled
+ * \detail	Many operations were referenced from Alexander G Dean's TSI project on GitHub
+ * 			(https://github.com/alexander-g-dean/ESF/tree/master/NXP/Misc/Touch%20Sense)
+ */
+static uint32_t scan_touch_blocking(void)
+{
+	TSI0->DATA = TSI_DATA_TSICH(TSI0_CHANNEL_10);
+	TSI0->DATA |= TSI_DATA_SWTS_MASK;
+
+	while(!(TSI0->GENCS & TSI_GENCS_EOSF_MASK));
+
+	TSI0->GENCS |= TSI_GENCS_EOSF_MASK;
+
+	return (TOUCH_DATA);
+}
+
+/**
+ * \fn		void set_touch_scan_length
+ * \param	uint8_t shift How far to shorten scans, from 0 to TOUCH_SCAN_SHIFT_MAX
+ * \return	N/A
+ * \brief   Change the number of electrode oscillations per scan. Leaves the TSI module enabled or
+ * 			disabled as it was
+ */
+static void set_touch_scan_length(uint8_t shift)
+{
+	uint32_t enabled = TSI0->GENCS & TSI_GENCS_TSIEN_MASK;
+
+	touch_scan_shift = shift;
+
+	/**
+	 * NSCN is changed with the TSI module disabled. The flags are masked out of both writes so a
+	 * pending one is not cleared by writing it back as 1
+	 */
+	TSI0->GENCS &= ~(TSI_GENCS_TSIEN_MASK | TSI_GENCS_EOSF_MASK | TSI_GENCS_OUTRGF_MASK);
+	TSI0->GENCS = (TSI0->GENCS & ~(TSI_GENCS_NSCN_MASK | TSI_GENCS_EOSF_MASK | TSI_GENCS_OUTRGF_MASK)) |
+		TSI_GENCS_NSCN(TOUCH_SCAN_NSCN(shift)) |
+		enabled;
+}
+
+/**
+ * \fn		void measure_touch_noise
+ * \param	uint8_t shift How far to shorten scans, from 0 to TOUCH_SCAN_SHIFT_MAX
+ * \param	uint32_t *mean Receives the average reading, in full-length counts
+ * \param	uint32_t *noise Receives the mean absolute distance of the readings from *mean, in
+ * 			full-length counts
+ * \return	N/A
+ * \brief   Take TOUCH_CALIBRATION_SCANS blocking scans of the untouched electrode at one scan length
+ */
+static void measure_touch_noise(uint8_t shift, uint32_t *mean, uint32_t *noise)
+{
+	uint32_t readings[TOUCH_CALIBRATION_SCANS];
+	uint32_t total = 0;
+	uint8_t scan;
+
+	set_touch_scan_length(shift);
+
+	for(scan = 0; scan < TOUCH_CALIBRATION_SCANS; scan++){
+		readings[scan] = scan_touch_blocking() << shift;
+		total += readings[scan];
+	}
+
+	*mean = total / TOUCH_CALIBRATION_SCANS;
+
+	total = 0;
+
+	for(scan = 0; scan < TOUCH_CALIBRATION_SCANS; scan++){
+		total += (readings[scan] > *mean) ? (readings[scan] - *mean) : (*mean - readings[scan]);
+	}
+
+	/**
+	 * Even when every scan agrees, a reading can be off by up to half a count of the shortened scan
+	 */
+	*noise = (total / TOUCH_CALIBRATION_SCANS) + ((1UL << shift) >> 1);
+}
+
+/**
+ * \fn		void calibrate_touch_sensor
+ * \param	N/A
+ * \return	N/A
+ * \brief   Starting from the shortest scan, lengthen scans until MIN_TOUCH is at least
+ * 			TOUCH_NOISE_MARGIN times the noise (or they are full length), and start touch_filter
+ * 			from what the untouched electrode read at that length
+ */
+static void calibrate_touch_sensor(void)
+{
+	uint8_t shift = TOUCH_ADAPTIVE_SCAN ? TOUCH_SCAN_SHIFT_MAX : 0;
+	uint32_t mean;
+	uint32_t noise;
+
+	measure_touch_noise(shift, &mean, &noise);
+
+	while((shift > 0) && (noise * TOUCH_NOISE_MARGIN > MIN_TOUCH)){
+		shift--;
+		measure_touch_noise(shift, &mean, &noise);
+	}
+
+	init_touch_filter(&touch_filter, mean, noise);
+}
+
+/**
+ * \fn		void set_touch_threshold
+ * \param	N/A
+ * \return	N/A
+ * \brief   In TOUCH_MODE_WAKE, only interrupt when a scan reads more than MIN_TOUCH above the
+ * 			current baseline. The low threshold is 0, so nothing is ever below range. The threshold is
+ * 			in counts of the current scan length
+ */
+static void set_touch_threshold(void)
+{
+	touch_threshold_baseline = touch_baseline(&touch_filter);
+
+#if TOUCH_MODE == TOUCH_MODE_WAKE
+	TSI0->TSHD =
+		TSI_TSHD_THRESH(((touch_threshold_baseline + MIN_TOUCH) >> touch_scan_shift) + 1) |
+		TSI_TSHD_THRESL(0);
+#endif
+}
+
+#if TOUCH_ADAPTIVE_SCAN
+/**
+ * \fn		void lengthen_touch_scan
+ * \param	N/A
+ * \return	N/A
+ * \brief   Double the scan length because the noise has risen, keeping the baseline. Doubling
+ * 			halves the rounding in each reading and averages out some of the noise, so the noise
+ * 			estimate starts again from half
+ */
+static void lengthen_touch_scan(void)
+{
+	set_touch_scan_length(touch_scan_shift - 1);
+	init_touch_filter(&touch_filter, touch_baseline(&touch_filter), touch_noise(&touch_filter) / 2);
+	set_touch_threshold();
+
+	/**
+	 * Whatever was scanned at the old length is stale
+	 */
+	discard_touch();
+	touch_settle = TOUCH_SETTLE_SAMPLES;
+}
+#endif
 
 void init_onboard_touch_sensor(void)
 {
@@ -28,7 +235,7 @@ void init_onboard_touch_sensor(void)
 	 * 	- Oscillator voltage rails set to default
 	 * 	- Electrode oscillator charge and discharge value of 500 nA
 	 * 	- Frequency clock divided by 1
-	 * 	- Scan electrode 32 times
+	 * 	- Scan electrode 32 times, until calibrate_touch_sensor() picks a length
 	 * 	- Enable the TSI module
 	 * 	- Write 1 to clear the end of scan flag
 	 */
@@ -41,10 +248,64 @@ void init_onboard_touch_sensor(void)
 			TSI_GENCS_NSCN(GENCS_NSCN) |\
 			TSI_GENCS_TSIEN_MASK |
 			TSI_GENCS_EOSF_MASK;
+
+	calibrate_touch_sensor();
+
+	/**
+	 * The scan mode and interrupt are changed with the TSI module disabled
+	 */
+	TSI0->GENCS &= ~TSI_GENCS_TSIEN_MASK;
+
+#if TOUCH_MODE == TOUCH_MODE_WAKE
+	set_touch_threshold();
+
+	/**
+	 * Configure TSI0 as:
+	 * 	- Scan when triggered by the LPTMR
+	 * 	- Keep scanning in stop modes, so a touch can wake the CPU
+	 * 	- Interrupt when a scan is out of range
+	 */
+	TSI0->DATA = TSI_DATA_TSICH(TSI0_CHANNEL_10);
+	TSI0->GENCS |=
+		TSI_GENCS_STM_MASK |
+		TSI_GENCS_STPE_MASK |
+		TSI_GENCS_TSIIEN_MASK;
+#else
+	/**
+	 * Configure TSI0 as:
+	 * 	- Interrupt at the end of each scan
+	 */
+	TSI0->GENCS |=
+		TSI_GENCS_TSIIEN_MASK |
+		TSI_GENCS_ESOR_MASK;
+#endif
+
+	TSI0->GENCS |= TSI_GENCS_TSIEN_MASK;
+
+	/**
+	 * Enable the TSI0 interrupt in the NVIC
+	 */
+	NVIC_SetPriority(TSI0_IRQn, TOUCH_IRQ_PRIORITY);
+	NVIC_EnableIRQ(TSI0_IRQn);
+
+#if TOUCH_MODE == TOUCH_MODE_WAKE
+	/**
+	 * Start the periodic hardware trigger
+	 */
+	init_onboard_lptmr();
+#endif
 }
 
-uint32_t get_touch(void)
+void start_touch_scan(void)
 {
+#if TOUCH_MODE == TOUCH_MODE_POLL
+	/**
+	 * The previous scan is still running, so its result will be the one taken next tick
+	 */
+	if(TSI0->GENCS & TSI_GENCS_SCNIP_MASK){
+		return;
+	}
+
 	/**
 	 * Select TSI0 channel 10
 	 */
@@ -54,32 +315,148 @@ uint32_t get_touch(void)
 	 * Software trigger to start scan
 	 */
 	TSI0->DATA |= TSI_DATA_SWTS_MASK;
+#endif
+}
 
-	/**
-	 * Wait for scan to complete 32 times
-	 */
-	while(!(TSI0->GENCS & TSI_GENCS_EOSF_MASK));
+bool get_touch(uint32_t *reading)
+{
+	bool return_value = false;
+
+	if(touch_fresh){
+		touch_fresh = false;
+
+		*reading = touch_reading;
+		return_value = true;
+	}
+
+	return (return_value);
+}
+
+void touch_scanned(uint32_t reading, uint32_t stamp)
+{
+	touch_reading = reading;
+	touch_reading_stamp = stamp;
+	touch_fresh = true;
+}
+
+bool touch_taken_stamp(uint32_t *stamp)
+{
+	bool return_value = touch_stamped;
+
+	if(touch_stamped){
+		*stamp = touch_sample_stamp;
+		touch_stamped = false;
+	}
+
+	return (return_value);
+}
+
+void discard_touch(void)
+{
+	touch_fresh = false;
+}
 
+bool touch_may_report(void)
+{
+	return ((touch_settle == 0) && touch_pending(&touch_filter));
+}
+
+void TSI0_IRQHandler(void)
+{
 	/**
-	 * Clear the end-of-scan flag
+	 * Clear the end-of-scan and out-of-range flags (write 1 to clear)
 	 */
-	TSI0->GENCS |= TSI_GENCS_EOSF_MASK;
+	TSI0->GENCS |= TSI_GENCS_EOSF_MASK | TSI_GENCS_OUTRGF_MASK;
 
 	/**
-	 * Now that scan has completed 32 times, return the raw data after subtracting TOUCH_OFFSET
+	 * Now that scan has completed 32 times, hand the raw data to the main loop
 	 */
-	return (TOUCH_DATA - TOUCH_OFFSET);
+	(void)event_publish(EVENT_TOUCH, TOUCH_DATA);
 }
 
-bool touchpad_is_touched(void)
+bool touchpad_is_touched(void *context)
 {
     /**
      * Check if touchpad has been touched
      */
 	bool return_value = false;
+	uint32_t stamp;
+	uint32_t raw;
+	uint32_t touch;
+	bool scanned;
+#if TOUCH_MODE == TOUCH_MODE_WAKE
+	uint32_t gencs;
+#endif
 
-	if(get_touch() > MIN_TOUCH){
-		return_value = true;
+	PROFILE_BEGIN(stamp);
+	scanned = get_touch(&raw);
+	PROFILE_END(PROBE_GET_TOUCH, stamp);
+
+	/**
+	 * Only a published scan has a stamp. A scan taken straight from the data register below has
+	 * none, so a touch it reports is not timed against an older scan's stamp
+	 */
+	if(scanned){
+		touch_sample_stamp = touch_reading_stamp;
+	}
+
+	touch_stamped = scanned;
+
+#if TOUCH_MODE == TOUCH_MODE_WAKE
+	/**
+	 * Scans that stay in range don't interrupt, but still land in the data register and set EOSF.
+	 * Take the latest one if it is new, so the baseline keeps following drift while the touchpad is
+	 * idle. An out-of-range scan is left to TSI0_IRQHandler(), which publishes it
+	 */
+	if(!scanned){
+		__disable_irq();
+		gencs = TSI0->GENCS;
+
+		if((gencs & TSI_GENCS_EOSF_MASK) && !(gencs & TSI_GENCS_OUTRGF_MASK)){
+			raw = TOUCH_DATA;
+			scanned = true;
+
+			/**
+			 * Clear EOSF (write 1 to clear) after the data is read, so a scan that ends in between is
+			 * not mistaken for the one taken. OUTRGF is written as 0 so a pending interrupt is kept
+			 */
+			TSI0->GENCS = gencs & ~TSI_GENCS_OUTRGF_MASK;
+		}
+
+		__enable_irq();
+	}
+#endif
+
+	/**
+	 * Only a new scan goes through the pipeline, so the debounce and the settling count scans
+	 * rather than calls
+	 */
+	if(scanned && touch_settle > 0){
+		touch_settle--;
+	}
+	else if(scanned){
+		touch = filter_touch(&touch_filter, raw << touch_scan_shift);
+		return_value = touch_detect(touch);
+
+		if(touch_baseline(&touch_filter) != touch_threshold_baseline){
+			set_touch_threshold();
+		}
+
+		/**
+		 * Every filtered sample is recorded, so a replay sees the same samples in the same order. The
+		 * filtered level is recorded rather than the raw value, since it depends on the pipeline's
+		 * history
+		 */
+		record_touch(touch);
+
+#if TOUCH_ADAPTIVE_SCAN
+		/**
+		 * Touches no longer stand far enough above the noise, so trade some scan time for margin
+		 */
+		if(!return_value && (touch_scan_shift > 0) && (touch_noise(&touch_filter) * TOUCH_NOISE_MARGIN > MIN_TOUCH)){
+			lengthen_touch_scan();
+		}
+#endif
 	}
 
 	return (return_value);
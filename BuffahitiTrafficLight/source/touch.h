@@ -88,6 +88,49 @@
 #define GENCS_NSCN\
 	(31UL)
 
+/**
+ * \def		TOUCH_ADAPTIVE_SCAN
+ * \brief	1 to pick the shortest scan that still separates touch from noise at calibration, and
+ * 			lengthen it again if the noise rises. 0 to always scan GENCS_NSCN + 1 times
+ */
+#ifndef TOUCH_ADAPTIVE_SCAN
+#define TOUCH_ADAPTIVE_SCAN\
+	(1)
+#endif
+
+/**
+ * \def		TOUCH_SCAN_SHIFT_MAX
+ * \brief	Scans are (GENCS_NSCN + 1) >> shift electrode oscillations long, for a shift from 0 up to
+ * 			this. Readings are shifted back up by the same amount, so the detector always works in
+ * 			full-length counts. The prescaler stays at GENCS_PS, since raising it only lengthens a scan
+ */
+#define TOUCH_SCAN_SHIFT_MAX\
+	(5)
+
+/**
+ * \def		TOUCH_NOISE_MARGIN
+ * \brief	A scan length is only used while MIN_TOUCH is at least this many times the noise, as
+ * 			the mean absolute distance of idle readings from the baseline
+ */
+#define TOUCH_NOISE_MARGIN\
+	(5)
+
+/**
+ * \def		TOUCH_SCAN_NSCN(shift)
+ * \param	shift How far the scan is shortened, from 0 to TOUCH_SCAN_SHIFT_MAX
+ * \brief	GENCS NSCN configuration for a scan shortened by shift
+ */
+#define TOUCH_SCAN_NSCN(shift)\
+	(((GENCS_NSCN + 1) >> (shift)) - 1)
+
+/**
+ * \def		TOUCH_SETTLE_SAMPLES
+ * \brief	Number of samples ignored after the scan length changes, so no scan of the old length is
+ * 			scaled as if it were the new one
+ */
+#define TOUCH_SETTLE_SAMPLES\
+	(2)
+
 /**
  * \def		TSI0_CHANNEL_10
  * \brief	TSI0 channel 10
@@ -95,14 +138,6 @@
 #define TSI0_CHANNEL_10\
 	(10UL)
 
-/**
- * \def		TOUCH_OFFSET
- * \brief	The amount to offset each scanned value by. Calculated by having 0 offset and then
- * 			printing the scanned value when touch sensor is not being touched
- */
-#define TOUCH_OFFSET\
-	(650)
-
 /**
  * \def		TOUCH_DATA
  * \brief	Grab the 16-bit scanned value data from the TSI0 Data register
@@ -112,14 +147,56 @@
 
 /**
  * \def		MIN_TOUCH
- * \brief	Any (scanned_value - TOUCH_OFFSET) greater than 100 will be considered a touch
+ * \brief	Any filtered (scanned_value - baseline) greater than 100 will be considered a touch
  */
 #define MIN_TOUCH\
 	(100)
 
+/**
+ * \def		TOUCH_MODE_POLL
+ * \brief	TOUCH_MODE where a scan is software triggered on every tick and interrupts when it ends
+ */
+#define TOUCH_MODE_POLL\
+	(0)
+
+/**
+ * \def		TOUCH_MODE_WAKE
+ * \brief	TOUCH_MODE where the LPTMR triggers a scan every LPTMR_PERIOD_COUNTS and the TSI only
+ * 			interrupts when a scan reads above the calibrated touch threshold, so an idle touchpad
+ * 			never wakes the CPU
+ */
+#define TOUCH_MODE_WAKE\
+	(1)
+
+/**
+ * \def		TOUCH_MODE
+ * \brief	How the touch sensor is scanned, TOUCH_MODE_POLL or TOUCH_MODE_WAKE
+ */
+#ifndef TOUCH_MODE
+#define TOUCH_MODE\
+	(TOUCH_MODE_WAKE)
+#endif
+
+/**
+ * \def		TOUCH_CALIBRATION_SCANS
+ * \brief	Number of scans of the untouched electrode averaged at boot to find its initial baseline
+ * 			and noise, for each scan length tried (a power of 2)
+ */
+#define TOUCH_CALIBRATION_SCANS\
+	(8)
+
+/**
+ * \def		TOUCH_IRQ_PRIORITY
+ * \brief	Priority of the TSI0 end-of-scan interrupt (range 0 to 3, with 0 being highest priority).
+ * 			It publishes events, so it must equal EVENT_IRQ_PRIORITY
+ */
+#define TOUCH_IRQ_PRIORITY\
+	(3)
+
 /**
  * \fn		void init_onboard_touch_sensor
- * \brief	Initialize capacitive touch sensor
+ * \brief	Initialize capacitive touch sensor, calibrate its baseline and scan length with a few
+ * 			blocking scans and start scanning it in the background as set by TOUCH_MODE
  * \param	N/A
  * \return 	N/A
  * \detail 	Many operations were referenced from Alexander G Dean's TSI project on GitHub
@@ -135,25 +212,89 @@
  *			TSIEN:	GENCS configuration for enabling/disabling TSI module. 0 to disable, 1 to enable
  *			EOSF:	GENCS configuration for end-of-scan flag. 0 means scan incomplete, 1 means scan complete.
  *					To clear this flag, write 1 to it
+ *			TSIIEN:	GENCS configuration for enabling the TSI interrupt
+ *			ESOR:	GENCS configuration for which event raises the interrupt. 0 for out-of-range, 1 for
+ *					end-of-scan
+ *			STM:	GENCS configuration for scan trigger. 0 for software (SWTS), 1 for hardware (LPTMR)
+ *			TSHD:	Threshold register. A scan outside THRESL to THRESH is out of range
+ *			NSCN:	GENCS configuration for the number of electrode oscillations per scan, minus 1
  */
 void init_onboard_touch_sensor(void);
 
 /**
- * \fn		uint32_t get_touch
- * \brief	Start scanning the touch sensor and return the relative touch value
+ * \fn		void start_touch_scan
  * \param	N/A
- * \return	The raw scanned value minus touch offset
+ * \return	N/A
+ * \brief	Software trigger a scan of the touch sensor and return straight away. Call once per
+ * 			tick. The scan finishes in TSI0_IRQHandler(), in time for the next tick. Does nothing if
+ * 			the previous scan has not finished yet, or in TOUCH_MODE_WAKE
  * \detail	Many operations were referenced from Alexander G Dean's TSI project on GitHub
  * 			(https://github.com/alexander-g-dean/ESF/tree/master/NXP/Misc/Touch%20Sense)
  */
-uint32_t get_touch(void);
+void start_touch_scan(void);
 
 /**
- * \fn		bool touchpad_is_touched
- * \brief	Will calculate the current touch value and determine whether touchpad is being touched
+ * \fn		bool get_touch
+ * \param	uint32_t *reading Receives the raw scanned value
+ * \return	Returns true if touch_scanned() has been given a scan since the last call, false if
+ * 			reading was not written
+ * \brief	Take the result of the latest finished scan. Never waits on the touch hardware
+ */
+bool get_touch(uint32_t *reading);
+
+/**
+ * \fn		void touch_scanned
+ * \param	uint32_t reading The raw value of an EVENT_TOUCH
+ * \param	uint32_t stamp The event's systick_counts() stamp
+ * \return	N/A
+ * \brief	Hand a finished scan to get_touch(). Main loop only, so the reading needs no lock
+ */
+void touch_scanned(uint32_t reading, uint32_t stamp);
+
+/**
+ * \fn		bool touch_taken_stamp
+ * \param	uint32_t *stamp Receives the stamp
+ * \return	Returns true if the latest sample touchpad_is_touched() took came from a scan handed to
+ * 			touch_scanned(), false if stamp was not written
+ * \brief	For timing a touch from its scan. Each stamp is only returned once
+ */
+bool touch_taken_stamp(uint32_t *stamp);
+
+/**
+ * \fn		void discard_touch
  * \param	N/A
- * \return	Returns true if the touch sensor detects a touch
+ * \return	N/A
+ * \brief	Drop the pending reading, if any, e.g. while the touch sensor is being ignored
+ */
+void discard_touch(void);
+
+/**
+ * \fn		bool touch_may_report
+ * \param	N/A
+ * \return	Returns true if the next sample touchpad_is_touched() takes can report a touch
+ * \brief	So the main loop can pick the clock a touch's work will run at before sampling
+ */
+bool touch_may_report(void);
+
+/**
+ * \fn		void TSI0_IRQHandler
+ * \param	N/A
+ * \return	N/A
+ * \brief   The ISR for TSI0 (i.e. runs each time a scan completes, or in TOUCH_MODE_WAKE each time
+ * 			a scan reads above the touch threshold). Publishes the scanned value as an EVENT_TOUCH
+ * \detail	FUNCTION NAME IS CASE SENSITIVE. Since it is weakly defined in
+ * 			startup\startup_mkl25z4.c this definition will override
+ */
+void TSI0_IRQHandler(void);
+
+/**
+ * \fn		bool touchpad_is_touched
+ * \brief	Will run the latest touch value through the detection pipeline and determine whether
+ * 			touchpad is being touched. touch_input_t for the traffic light on the on-board touchpad
+ * \param	void *context Unused, there is only one on-board touchpad
+ * \return	Returns true if a touch is being reported. False if there has been no new scan since the
+ * 			last call
  */
-bool touchpad_is_touched(void);
+bool touchpad_is_touched(void *context);
 
 #endif /* TOUCH_H_ */
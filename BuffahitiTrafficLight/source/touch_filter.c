@@ -0,0 +1,128 @@
+/**
+ * \file    touch_filter.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Function definitions for the fixed-point touch detection pipeline
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * User-defined libraries
+ */
+#include "touch.h"
+#include "touch_filter.h"
+
+void init_touch_filter(touch_filter_t *filter, uint32_t baseline, uint32_t noise)
+{
+	filter->baseline = (int32_t)baseline << TOUCH_FILTER_FRAC_BITS;
+	filter->level = 0;
+	filter->noise = (int32_t)noise << TOUCH_FILTER_FRAC_BITS;
+	filter->agree = 0;
+	filter->on_samples = 0;
+	filter->touched = false;
+}
+
+uint32_t filter_touch(touch_filter_t *filter, uint32_t raw)
+{
+	uint32_t return_value;
+	int32_t delta = ((int32_t)raw << TOUCH_FILTER_FRAC_BITS) - filter->baseline;
+	int32_t level;
+
+	/**
+	 * One-pole low-pass of the signed distance from the baseline. Shifting a negative value right
+	 * is arithmetic on this compiler, so both directions round the same way
+	 */
+	filter->level += (delta - filter->level) >> TOUCH_FILTER_SHIFT;
+	level = filter->level >> TOUCH_FILTER_FRAC_BITS;
+
+	if(!filter->touched){
+		/**
+		 * Only report a touch after TOUCH_DEBOUNCE_SAMPLES filtered samples in a row above MIN_TOUCH
+		 */
+		if(level > MIN_TOUCH){
+			filter->agree++;
+		}
+		else{
+			filter->agree = 0;
+
+			/**
+			 * Idle, so let the baseline follow slow drift in the untouched electrode and measure how
+			 * far the samples scatter around it
+			 */
+			if(delta > 0){
+				filter->baseline += delta >> TOUCH_BASELINE_UP_SHIFT;
+				filter->noise += (delta - filter->noise) >> TOUCH_NOISE_SHIFT;
+			}
+			else{
+				filter->baseline += delta >> TOUCH_BASELINE_DOWN_SHIFT;
+				filter->noise += (-delta - filter->noise) >> TOUCH_NOISE_SHIFT;
+			}
+		}
+
+		if(filter->agree >= TOUCH_DEBOUNCE_SAMPLES){
+			filter->touched = true;
+			filter->agree = 0;
+			filter->on_samples = 0;
+		}
+	}
+	else{
+		/**
+		 * Only report a release after TOUCH_DEBOUNCE_SAMPLES filtered samples in a row at or below
+		 * TOUCH_RELEASE
+		 */
+		if(level <= TOUCH_RELEASE){
+			filter->agree++;
+		}
+		else{
+			filter->agree = 0;
+		}
+
+		filter->on_samples++;
+
+		if(filter->agree >= TOUCH_DEBOUNCE_SAMPLES){
+			filter->touched = false;
+			filter->agree = 0;
+		}
+		else if(filter->on_samples > TOUCH_MAX_ON_SAMPLES){
+			/**
+			 * Nobody holds a touch this long, so the electrode itself has moved. Start again from here
+			 */
+			init_touch_filter(filter, raw, touch_noise(filter));
+			level = 0;
+		}
+	}
+
+	/**
+	 * Clamp the level to the side of MIN_TOUCH that matches the debounced decision
+	 */
+	if(filter->touched){
+		return_value = (level > MIN_TOUCH) ? (uint32_t)level : (MIN_TOUCH + 1);
+	}
+	else{
+		return_value = (level <= 0) ? 0 : ((level > MIN_TOUCH) ? MIN_TOUCH : (uint32_t)level);
+	}
+
+	return (return_value);
+}
+
+uint32_t touch_baseline(const touch_filter_t *filter)
+{
+	return ((uint32_t)(filter->baseline >> TOUCH_FILTER_FRAC_BITS));
+}
+
+uint32_t touch_noise(const touch_filter_t *filter)
+{
+	return ((uint32_t)(filter->noise >> TOUCH_FILTER_FRAC_BITS));
+}
+
+bool touch_detect(uint32_t reading)
+{
+	return (reading > MIN_TOUCH);
+}
+
+bool touch_pending(const touch_filter_t *filter)
+{
+	return (filter->touched || (filter->agree + 1 >= TOUCH_DEBOUNCE_SAMPLES));
+}
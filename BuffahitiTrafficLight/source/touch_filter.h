@@ -0,0 +1,150 @@
+/**
+ * \file    touch_filter.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Macros and function headers for the fixed-point touch detection pipeline
+ */
+
+#ifndef TOUCH_FILTER_H_
+#define TOUCH_FILTER_H_
+
+/**
+ * \def		TOUCH_FILTER_FRAC_BITS
+ * \brief	Number of fraction bits in the baseline and filtered level, so slow tracking does not
+ * 			lose everything below 1 count
+ */
+#define TOUCH_FILTER_FRAC_BITS\
+	(8)
+
+/**
+ * \def		TOUCH_FILTER_SHIFT
+ * \brief	The filtered level moves 1 / 2^TOUCH_FILTER_SHIFT of the way to each new sample. Enough
+ * 			to take the edge off single-scan noise without delaying a touch by more than a scan
+ */
+#define TOUCH_FILTER_SHIFT\
+	(1)
+
+/**
+ * \def		TOUCH_BASELINE_UP_SHIFT
+ * \brief	While idle, the baseline moves 1 / 2^TOUCH_BASELINE_UP_SHIFT of the way up to each sample
+ * 			above it. Slow, so an approaching hand is not absorbed into the baseline
+ */
+#define TOUCH_BASELINE_UP_SHIFT\
+	(6)
+
+/**
+ * \def		TOUCH_BASELINE_DOWN_SHIFT
+ * \brief	While idle, the baseline moves 1 / 2^TOUCH_BASELINE_DOWN_SHIFT of the way down to each
+ * 			sample below it. Faster than up, since a reading below the baseline is never a touch
+ */
+#define TOUCH_BASELINE_DOWN_SHIFT\
+	(3)
+
+/**
+ * \def		TOUCH_NOISE_SHIFT
+ * \brief	While idle, the noise estimate moves 1 / 2^TOUCH_NOISE_SHIFT of the way to each sample's
+ * 			distance from the baseline
+ */
+#define TOUCH_NOISE_SHIFT\
+	(6)
+
+/**
+ * \def		TOUCH_RELEASE
+ * \brief	Once touched, the filtered level has to fall to this many counts above the baseline or
+ * 			less to count towards a release. Below MIN_TOUCH, so noise at the threshold can't chatter
+ */
+#define TOUCH_RELEASE\
+	(MIN_TOUCH / 2)
+
+/**
+ * \def		TOUCH_DEBOUNCE_SAMPLES
+ * \brief	Number of samples in a row that have to agree before a touch or a release is reported
+ */
+#define TOUCH_DEBOUNCE_SAMPLES\
+	(2)
+
+/**
+ * \def		TOUCH_MAX_ON_SAMPLES
+ * \brief	A touch held for more samples than this is taken to be drift (or something left on the
+ * 			pad) and the baseline is recalibrated to it
+ */
+#define TOUCH_MAX_ON_SAMPLES\
+	(1024)
+
+/**
+ * \typedef	touch_filter_t
+ * \brief	To allow objects of struct touch_filter_s to be declared with ease
+ */
+typedef struct touch_filter_s touch_filter_t;
+
+/**
+ * \struct	touch_filter_s
+ * \brief	State of one touch detection pipeline. baseline, level and noise have
+ * 			TOUCH_FILTER_FRAC_BITS fraction bits, and level is signed so a reading below the baseline
+ * 			can never wrap around into a touch. noise is the mean absolute distance of idle samples
+ * 			from the baseline
+ */
+struct touch_filter_s {
+	int32_t baseline;
+	int32_t level;
+	int32_t noise;
+	uint16_t agree;
+	uint16_t on_samples;
+	bool touched;
+};
+
+/**
+ * \fn		void init_touch_filter
+ * \param	touch_filter_t *filter The pipeline to initialize
+ * \param	uint32_t baseline Raw scanned value of the untouched electrode
+ * \param	uint32_t noise Starting noise estimate, in raw counts
+ * \return	N/A
+ * \brief   Start the pipeline untouched, at baseline
+ */
+void init_touch_filter(touch_filter_t *filter, uint32_t baseline, uint32_t noise);
+
+/**
+ * \fn		uint32_t filter_touch
+ * \param	touch_filter_t *filter The pipeline
+ * \param	uint32_t raw A raw scanned value
+ * \return	The debounced touch level in counts above the baseline. Greater than MIN_TOUCH exactly
+ * 			when a touch is reported, so touch_detect() can judge it on its own
+ * \brief   Run one sample through the pipeline: filter, debounce with hysteresis, and track the
+ * 			baseline and noise while idle. Integer math only
+ */
+uint32_t filter_touch(touch_filter_t *filter, uint32_t raw);
+
+/**
+ * \fn		uint32_t touch_baseline
+ * \param	const touch_filter_t *filter The pipeline
+ * \return	The current baseline, in raw counts
+ * \brief   For setting hardware thresholds relative to the baseline
+ */
+uint32_t touch_baseline(const touch_filter_t *filter);
+
+/**
+ * \fn		uint32_t touch_noise
+ * \param	const touch_filter_t *filter The pipeline
+ * \return	The current noise estimate, in raw counts
+ * \brief   For judging whether touches can still be told apart from noise
+ */
+uint32_t touch_noise(const touch_filter_t *filter);
+
+/**
+ * \fn		bool touch_detect
+ * \param	uint32_t reading A level returned by filter_touch()
+ * \return	Returns true if reading counts as a touch
+ * \brief	The touch detector on its own, so recorded readings can be judged exactly like live ones
+ */
+bool touch_detect(uint32_t reading);
+
+/**
+ * \fn		bool touch_pending
+ * \param	const touch_filter_t *filter The pipeline
+ * \return	Returns true if the next sample can report a touch, i.e. one is already reported or the
+ * 			debounce is a sample short of it
+ * \brief	Look ahead at the pipeline without feeding it
+ */
+bool touch_pending(const touch_filter_t *filter);
+
+#endif /* TOUCH_FILTER_H_ */
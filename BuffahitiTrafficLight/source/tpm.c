@@ -30,14 +30,17 @@ void init_onboard_tpm(void)
 	SIM->SCGC6 |= SIM_SCGC6_TPM0_MASK;
 	SIM->SCGC6 |= SIM_SCGC6_TPM2_MASK;
 
+	/**
+	 * Keep OSCERCLK running, including in stop modes
+	 */
+	OSC0->CR |= OSC_CR_ERCLKEN_MASK | OSC_CR_EREFSTEN_MASK;
+
 	/**
      * Configure SOPT2:
-     * 	- To use MCGFLLCLK and MCGPLLCLK/2 as clock source
-     * 	- To select FLL clock from above
+     * 	- To use OSCERCLK as clock source
      */
-	SIM->SOPT2 |=
-		SIM_SOPT2_TPMSRC(TPM_CLOCK_SRC) |
-		SIM_SOPT2_PLLFLLSEL_MASK;
+	SIM->SOPT2 = (SIM->SOPT2 & ~SIM_SOPT2_TPMSRC_MASK) |
+		SIM_SOPT2_TPMSRC(TPM_CLOCK_SRC);
 
 	/**
      * Set the smallest needed prescaler along with PWM period for desired PWM frequency
@@ -47,8 +50,8 @@ void init_onboard_tpm(void)
 	/**
      * Load the TPM MOD register
      */
-	TPM0->MOD = TPM_RGB_MOD;
-	TPM2->MOD = TPM_RGB_MOD;
+	TPM0->MOD = TPM_PWM_MOD;
+	TPM2->MOD = TPM_PWM_MOD;
 
 	/**
      * Configure the TPM SC register:
@@ -86,9 +89,19 @@ void init_onboard_tpm(void)
 	TPM2->CONTROLS[0].CnV = 0;
 	TPM2->CONTROLS[1].CnV = 0;
 
+	/**
+     * Enable the TPM2 interrupt in the NVIC. Its overflow interrupt (TOIE) is only turned on while
+     * a fade is running
+     */
+	NVIC_SetPriority(TPM2_IRQn, TPM_IRQ_PRIORITY);
+	NVIC_EnableIRQ(TPM2_IRQn);
+
 	/**
      * Configure the TPM SC register:
      * 	- Start TPM
+     *
+     * TPM0 is started first so that each TPM2 overflow comes just after TPM0's, and CnV writes made
+     * on a TPM2 overflow are latched by both modules at the same reload
      */
 	TPM0->SC |= TPM_SC_CMOD(1);
 	TPM2->SC |= TPM_SC_CMOD(1);
@@ -97,36 +110,8 @@ void init_onboard_tpm(void)
 uint8_t get_prescaler(void)
 {
 	/**
-     * Calculate the smallest needed prescaler to allow for largest possible TPM->MOD value
-     * and thus more granular control
+     * The smallest needed prescaler to allow for largest possible TPM->MOD value and thus more
+     * granular control. Resolved at compile time so TPM_PWM_MOD can size the gamma table
      */
-
-	uint8_t return_value;
-
-	if(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 1){
-		return_value = 0;
-	}
-	else if(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 2){
-		return_value = 1;
-	}
-	else if(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 4){
-		return_value = 2;
-	}
-	else if(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 8){
-		return_value = 3;
-	}
-	else if(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 16){
-		return_value = 4;
-	}
-	else if(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 32){
-		return_value = 5;
-	}
-	else if(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 64){
-		return_value = 6;
-	}
-	else{
-		return_value = 7;
-	}
-
-	return (return_value);
+	return (TPM_PRESCALER);
 }
@@ -24,7 +24,8 @@
 
 /**
  * \def		TPM_CLOCK_SRC
- * \brief	Configuration for TPM clock source select
+ * \brief	Configuration for TPM clock source select. OSCERCLK is the 8 MHz crystal, which keeps
+ * 			running in VLPS, so the LEDs hold their duty cycles while the CPU is stopped
  * \detail
  * 		0: Disabled
  * 		1: MCGFLLCLK (or MCGPLLCLK / 2)
@@ -32,7 +33,7 @@
  * 		3: MCGIRCLK
  */
 #define TPM_CLOCK_SRC\
-	(1)
+	(2)
 
 /**
  * \def		TPM_DBGMODE
@@ -50,7 +51,7 @@
  * \brief	The frequency of TPM clock in Hz
  */
 #define F_TPM_CLOCK_HZ\
-	(48000000)
+	(8000000)
 
 /**
  * \def		RED_LED_TPM2_CHANNEL
@@ -74,12 +75,35 @@
 	(1)
 
 /**
- * \def		TPM_RGB_MOD
- * \brief	The value to load into TPM->MOD register. Set to 255 because we are working with RGB
- * \detail
+ * \def		TPM_PRESCALER
+ * \brief	x for 2^x, where 2^x is the smallest TPM prescaler that lets one PWM period at
+ * 			PWM_FREQ_HZ fit in the 16-bit TPM->MOD register. Resolved at compile time
+ */
+#define TPM_PRESCALER\
+	((((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 1) ? 0 :\
+	(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 2) ? 1 :\
+	(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 4) ? 2 :\
+	(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 8) ? 3 :\
+	(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 16) ? 4 :\
+	(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 32) ? 5 :\
+	(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) / MAX_TPM_MOD_VALUE) < 64) ? 6 : 7)
+
+/**
+ * \def		TPM_PWM_MOD
+ * \brief	The value to load into TPM->MOD register for one PWM period at PWM_FREQ_HZ. This is
+ * 			also the number of distinct duty cycles (F_TPM_CLOCK_HZ / PWM_FREQ_HZ - 1, i.e. 15999 at
+ * 			500 Hz), so the gamma table maps RGB levels onto the full resolution of the TPM
+ */
+#define TPM_PWM_MOD\
+	(((F_TPM_CLOCK_HZ / PWM_FREQ_HZ) >> TPM_PRESCALER) - 1)
+
+/**
+ * \def		TPM_IRQ_PRIORITY
+ * \brief	Priority of the TPM2 overflow interrupt that drives fades (range 0 to 3, with 0 being
+ * 			highest priority). Above SysTick so a late tick never stalls a fade
  */
-#define TPM_RGB_MOD\
-	(255)
+#define TPM_IRQ_PRIORITY\
+	(2)
 
 /**
  * \var		extern uint8_t tpm_sc_ps;
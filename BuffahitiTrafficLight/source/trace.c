@@ -0,0 +1,114 @@
+/**
+ * \file    trace.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Function definitions for deferred trace events
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fsl_debug_console.h"
+
+/**
+ * User-defined libraries
+ */
+#include "fsm_trafficlight.h"
+#include "systick.h"
+#include "trace.h"
+
+/**
+ * \typedef	trace_event_t
+ * \brief	To allow objects of struct trace_event_s to be declared with ease
+ */
+typedef struct trace_event_s trace_event_t;
+
+/**
+ * \struct	trace_event_s
+ * \brief	One queued trace event
+ */
+struct trace_event_s {
+	ticktime_t tick;
+	uint8_t kind;
+	uint8_t arg0;
+	uint8_t arg1;
+};
+
+/**
+ * \var		trace_event_t trace_events[TRACE_DEPTH]
+ * \brief	Queue of events not printed yet
+ */
+static trace_event_t trace_events[TRACE_DEPTH];
+
+/**
+ * \var		uint8_t trace_head
+ * \brief	Index of the oldest queued event
+ */
+static uint8_t trace_head;
+
+/**
+ * \var		uint8_t trace_count
+ * \brief	Number of queued events
+ */
+static uint8_t trace_count;
+
+/**
+ * \var		uint32_t trace_dropped
+ * \brief	Events dropped because the queue was full, since this was last printed
+ */
+static uint32_t trace_dropped;
+
+void trace_push(trace_kind_t kind, uint8_t arg0, uint8_t arg1)
+{
+	trace_event_t *event;
+
+	if(trace_count == TRACE_DEPTH){
+		trace_dropped++;
+		return;
+	}
+
+	event = &trace_events[(trace_head + trace_count) % TRACE_DEPTH];
+	event->tick = ticks_since_startup;
+	event->kind = kind;
+	event->arg0 = arg0;
+	event->arg1 = arg1;
+
+	trace_count++;
+}
+
+void trace_drain(void)
+{
+	trace_event_t *event;
+	uint32_t msec;
+	uint8_t printed;
+
+	for(printed = 0; printed < TRACE_DRAIN_MAX && trace_count > 0; printed++){
+		event = &trace_events[trace_head];
+		msec = ticks_to_msec(event->tick);
+
+		switch(event->kind){
+		case TRACE_BOOT:
+			PRINTF("%07u ms: Entering main loop...\r\n", msec);
+			PRINTF("%07u ms: Initialized to %s. Staying for %u sec...\r\n", msec, mode_to_string(event->arg0), mode_state_sec(event->arg0));
+			break;
+		case TRACE_TRANSITION:
+			PRINTF("%07u ms: Transitioning from %s to %s\r\n", msec, mode_to_string(event->arg0), mode_to_string(event->arg1));
+			break;
+		case TRACE_STABLE:
+			PRINTF("%07u ms: Done transitioning to %s. Staying for %u sec...\r\n", msec, mode_to_string(event->arg0), mode_state_sec(event->arg0));
+			break;
+		case TRACE_CATCHUP:
+			PRINTF("%07u ms: Caught up on %u late ticks\r\n", msec, event->arg0);
+			break;
+		default:
+			break;
+		}
+
+		trace_head = (trace_head + 1) % TRACE_DEPTH;
+		trace_count--;
+	}
+
+	if(trace_count == 0 && trace_dropped > 0){
+		PRINTF("%07u ms: %u trace events dropped\r\n", now(), trace_dropped);
+		trace_dropped = 0;
+	}
+}
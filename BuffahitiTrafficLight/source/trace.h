@@ -0,0 +1,103 @@
+/**
+ * \file    trace.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Macros and function headers for deferred trace events
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/**
+ * \def		TRACE_ENABLE
+ * \brief	1 to queue and print trace events, 0 to compile every trace hook to nothing. On by
+ * 			default in DEBUG only, so DEBUG and NDEBUG builds share the exact same control code
+ */
+#ifndef TRACE_ENABLE
+#ifdef DEBUG
+#define TRACE_ENABLE\
+	(1)
+#else
+#define TRACE_ENABLE\
+	(0)
+#endif
+#endif
+
+/**
+ * \def		TRACE_DEPTH
+ * \brief	Number of events that can be queued before new ones are dropped (a power of 2)
+ */
+#define TRACE_DEPTH\
+	(16)
+
+/**
+ * \def		TRACE_DRAIN_MAX
+ * \brief	Most events printed per call to TRACE_DRAIN(), which bounds the time tracing can add to
+ * 			one tick
+ */
+#define TRACE_DRAIN_MAX\
+	(2)
+
+/**
+ * \typedef	trace_kind_t
+ * \brief	To allow objects of enum trace_kind_e to be declared with ease
+ */
+typedef enum trace_kind_e trace_kind_t;
+
+/**
+ * \enum	trace_kind_e
+ * \brief	What a trace event reports. The meaning of its two arguments depends on this
+ */
+enum trace_kind_e {
+	TRACE_BOOT,			/* arg0: initial mode */
+	TRACE_TRANSITION,	/* arg0: mode left, arg1: mode entered */
+	TRACE_STABLE,		/* arg0: mode that became stable */
+	TRACE_CATCHUP		/* arg0: ticks the main loop was late for (saturates at 255) */
+};
+
+#if TRACE_ENABLE
+/**
+ * \def		TRACE_EVENT(kind, arg0, arg1)
+ * \param	kind	The trace_kind_t of the event
+ * \param	arg0	First argument, see trace_kind_e
+ * \param	arg1	Second argument, see trace_kind_e
+ * \brief	Queue an event stamped with the current tick. Never prints, so it costs the same
+ * 			regardless of the console
+ */
+#define TRACE_EVENT(kind, arg0, arg1)\
+	(trace_push((kind), (arg0), (arg1)))
+
+/**
+ * \def		TRACE_DRAIN()
+ * \brief	Print up to TRACE_DRAIN_MAX queued events over the debug console
+ */
+#define TRACE_DRAIN()\
+	(trace_drain())
+#else
+#define TRACE_EVENT(kind, arg0, arg1)\
+	((void)(arg0), (void)(arg1))
+#define TRACE_DRAIN()\
+	((void)0)
+#endif
+
+/**
+ * \fn		void trace_push
+ * \param	trace_kind_t kind The kind of event
+ * \param	uint8_t arg0 First argument, see trace_kind_e
+ * \param	uint8_t arg1 Second argument, see trace_kind_e
+ * \return	N/A
+ * \brief   Queue an event. Use TRACE_EVENT() instead so it compiles out of NDEBUG builds. Main
+ * 			loop context only
+ */
+void trace_push(trace_kind_t kind, uint8_t arg0, uint8_t arg1);
+
+/**
+ * \fn		void trace_drain
+ * \param	N/A
+ * \return	N/A
+ * \brief   Print up to TRACE_DRAIN_MAX queued events, oldest first, plus a count of any that had
+ * 			to be dropped. Use TRACE_DRAIN() instead so it compiles out of NDEBUG builds
+ */
+void trace_drain(void);
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,356 @@
+/**
+ * \file    bench_hotpath.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host benchmark of the per-tick hot path, the same code the on-target profiler times:
+ * 			update_fsm() in each scenario, and step_leds(), transition_state() and filter_touch()
+ * 			on their own. The light drives the stubbed TPM registers through output_onboard_leds().
+ * 			Prints one line per measurement:
+ * 			hotpath,<scenario>,<function>,<calls>,<host insns per call>,<ns per call>
+ * 			Instruction counts are of the host CPU, so compare them with each other over time
+ * 			rather than with the Cortex-M0+
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * User-defined libraries
+ */
+#include "fsm_trafficlight.h"
+#include "host.h"
+#include "led.h"
+#include "swtimer.h"
+#include "systick.h"
+#include "touch.h"
+#include "touch_filter.h"
+
+/**
+ * \def		BENCH_ROUNDS
+ * \brief	Times each scenario is set up from a fresh light and timed
+ */
+#define BENCH_ROUNDS\
+	(20000)
+
+/**
+ * \def		BENCH_COPIES
+ * \brief	Lights timed side by side for the functions that are timed on their own
+ */
+#define BENCH_COPIES\
+	(4096)
+
+/**
+ * \def		BENCH_SAMPLES
+ * \brief	Length of the touch trace fed to filter_touch()
+ */
+#define BENCH_SAMPLES\
+	(1 << 16)
+
+/**
+ * \typedef	bench_acc_t
+ * \brief	To allow objects of struct bench_acc_s to be declared with ease
+ */
+typedef struct bench_acc_s bench_acc_t;
+
+/**
+ * \typedef	bench_done_t
+ * \brief	Whether a light has reached the start of a scenario
+ */
+typedef bool (*bench_done_t)(const trafficlight_t *tl);
+
+/**
+ * \struct	bench_acc_s
+ * \brief	What the timed calls of one measurement have added up to
+ */
+struct bench_acc_s {
+	uint64_t calls;
+	uint64_t insns;
+	uint64_t nsec;
+};
+
+/**
+ * \var		bool bench_pressed
+ * \brief	What the light's input returns on its next sample
+ */
+static bool bench_pressed;
+
+/**
+ * \var		trafficlight_t bench_light, bench_copies[BENCH_COPIES]
+ * \brief	The light the scenarios run on, and the copies timed side by side
+ */
+static trafficlight_t bench_light;
+static trafficlight_t bench_copies[BENCH_COPIES];
+
+/**
+ * \var		swtimer_wheel_t bench_wheel
+ * \brief	bench_light's timers
+ */
+static swtimer_wheel_t bench_wheel;
+
+/**
+ * \var		uint32_t bench_trace[BENCH_SAMPLES]
+ * \brief	Raw scans fed to filter_touch()
+ */
+static uint32_t bench_trace[BENCH_SAMPLES];
+
+/**
+ * \var		volatile uint32_t bench_sink
+ * \brief	Where results go so they can't be optimized away
+ */
+static volatile uint32_t bench_sink;
+
+/**
+ * \fn		bool bench_input
+ * \param	void *context Unused
+ * \return	Returns bench_pressed, once
+ * \brief   touch_input_t of bench_light
+ */
+static bool bench_input(void *context)
+{
+	bool return_value = bench_pressed;
+
+	bench_pressed = false;
+
+	return (return_value);
+}
+
+/**
+ * \fn		bool in_stable_go, in_fade, in_crosswalk
+ * \param	const trafficlight_t *tl The light
+ * \return	Returns true once tl has reached the start of the scenario
+ * \brief   Starts of the scenarios
+ */
+static bool in_stable_go(const trafficlight_t *tl)
+{
+	return ((tl->current.mode == GO) && !tl->transitioning);
+}
+
+static bool in_fade(const trafficlight_t *tl)
+{
+	return (tl->transitioning);
+}
+
+static bool in_crosswalk(const trafficlight_t *tl)
+{
+	return ((tl->current.mode == CROSSWALK) && !tl->transitioning);
+}
+
+/**
+ * \fn		void run_until
+ * \param	bench_done_t done The start of the scenario
+ * \return	N/A
+ * \brief   Run bench_light a tick at a time, untimed, until done
+ */
+static void run_until(bench_done_t done)
+{
+	while(!done(&bench_light)){
+		ticks_since_startup++;
+		update_fsm(&bench_light);
+	}
+}
+
+/**
+ * \fn		void fresh_light
+ * \param	N/A
+ * \return	N/A
+ * \brief   Start bench_light over in STOP, so every round sees the same light
+ */
+static void fresh_light(void)
+{
+	init_swtimer_wheel(&bench_wheel, ticks_since_startup);
+	init_fsm_trafficlight(&bench_light, &bench_wheel, bench_input, NULL, output_onboard_leds);
+}
+
+/**
+ * \fn		void time_ticks
+ * \param	uint32_t ticks Ticks to run
+ * \param	bench_acc_t *acc Receives the time they took
+ * \return	N/A
+ * \brief   Run bench_light for ticks ticks with update_fsm(), timed
+ */
+static void time_ticks(uint32_t ticks, bench_acc_t *acc)
+{
+	uint64_t insns_start = host_instructions();
+	uint64_t nsec_start = host_nsec();
+	uint32_t tick;
+
+	for(tick = 0; tick < ticks; tick++){
+		ticks_since_startup++;
+		update_fsm(&bench_light);
+	}
+
+	acc->nsec += host_nsec() - nsec_start;
+	acc->insns += host_instructions() - insns_start;
+	acc->calls += ticks;
+}
+
+/**
+ * \fn		void print_acc
+ * \param	const char *scenario The scenario
+ * \param	const char *function What was timed
+ * \param	const bench_acc_t *acc What it added up to
+ * \return	N/A
+ * \brief   Print one measurement
+ */
+static void print_acc(const char *scenario, const char *function, const bench_acc_t *acc)
+{
+	uint64_t centi_nsec = (acc->nsec * 100) / acc->calls;
+
+	printf("hotpath,%s,%s,%llu,%llu,%llu.%02llu\n",
+		scenario,
+		function,
+		(unsigned long long)acc->calls,
+		(unsigned long long)(acc->insns / acc->calls),
+		(unsigned long long)(centi_nsec / 100),
+		(unsigned long long)(centi_nsec % 100));
+}
+
+/**
+ * \fn		void bench_update_fsm
+ * \param	N/A
+ * \return	N/A
+ * \brief   update_fsm() on the ticks of a stable GO, of a GO to WARNING fade, of a CROSSWALK
+ * 			blinking, and on the tick a touch preempts a stable GO
+ */
+static void bench_update_fsm(void)
+{
+	bench_acc_t stable = {0};
+	bench_acc_t fade = {0};
+	bench_acc_t crosswalk = {0};
+	bench_acc_t touch = {0};
+	uint32_t round;
+
+	for(round = 0; round < BENCH_ROUNDS; round++){
+		fresh_light();
+		run_until(in_stable_go);
+
+	    /**
+	     * The last tick of the dwell starts the fade, so it is left out
+	     */
+		time_ticks(mode_table[GO].dwell_ticks - 1, &stable);
+		run_until(in_fade);
+		time_ticks(TICKS_PER_TRANSITION - 1, &fade);
+
+		fresh_light();
+		run_until(in_stable_go);
+		bench_pressed = true;
+		time_ticks(1, &touch);
+		run_until(in_crosswalk);
+		time_ticks(mode_table[CROSSWALK].dwell_ticks - 1, &crosswalk);
+	}
+
+	print_acc("stable", "update_fsm", &stable);
+	print_acc("fade", "update_fsm", &fade);
+	print_acc("crosswalk", "update_fsm", &crosswalk);
+	print_acc("touch", "update_fsm", &touch);
+}
+
+/**
+ * \fn		void bench_fade_functions
+ * \param	N/A
+ * \return	N/A
+ * \brief   transition_state() out of a stable GO, then each step_leds() of the fade it starts,
+ * 			over BENCH_COPIES copies of the light so the timer is read rarely
+ */
+static void bench_fade_functions(void)
+{
+	bench_acc_t transition = {0};
+	bench_acc_t step = {0};
+	uint64_t insns_start;
+	uint64_t nsec_start;
+	uint32_t round;
+	uint32_t copy;
+	uint32_t n;
+
+	for(round = 0; round < BENCH_ROUNDS / 100; round++){
+		fresh_light();
+		run_until(in_stable_go);
+
+		for(copy = 0; copy < BENCH_COPIES; copy++){
+			bench_copies[copy] = bench_light;
+		}
+
+		insns_start = host_instructions();
+		nsec_start = host_nsec();
+
+		for(copy = 0; copy < BENCH_COPIES; copy++){
+			transition_state(&bench_copies[copy]);
+		}
+
+		transition.nsec += host_nsec() - nsec_start;
+		transition.insns += host_instructions() - insns_start;
+		transition.calls += BENCH_COPIES;
+
+		insns_start = host_instructions();
+		nsec_start = host_nsec();
+
+		for(n = 0; n < FADE_TICK_STEPS; n++){
+			for(copy = 0; copy < BENCH_COPIES; copy++){
+				step_leds(&bench_copies[copy]);
+			}
+		}
+
+		step.nsec += host_nsec() - nsec_start;
+		step.insns += host_instructions() - insns_start;
+		step.calls += (uint64_t)FADE_TICK_STEPS * BENCH_COPIES;
+
+		bench_sink += bench_copies[BENCH_COPIES - 1].current.red_level;
+	}
+
+	print_acc("fade", "transition_state", &transition);
+	print_acc("fade", "step_leds", &step);
+}
+
+/**
+ * \fn		void bench_filter_touch
+ * \param	N/A
+ * \return	N/A
+ * \brief   filter_touch() over a noisy trace with a touch every few hundred samples, which is what
+ * 			get_touch() hands it on the board
+ */
+static void bench_filter_touch(void)
+{
+	bench_acc_t filter = {0};
+	touch_filter_t touch_filter;
+	uint32_t seed = 2463534242UL;
+	uint64_t insns_start;
+	uint64_t nsec_start;
+	uint32_t round;
+	uint32_t n;
+
+	for(n = 0; n < BENCH_SAMPLES; n++){
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		bench_trace[n] = 1000 + (seed % 17) + (((n % 500) < 20) ? (3 * MIN_TOUCH) : 0);
+	}
+
+	init_touch_filter(&touch_filter, 1000, 8);
+
+	for(round = 0; round < BENCH_ROUNDS / 1000; round++){
+		insns_start = host_instructions();
+		nsec_start = host_nsec();
+
+		for(n = 0; n < BENCH_SAMPLES; n++){
+			bench_sink += filter_touch(&touch_filter, bench_trace[n]);
+		}
+
+		filter.nsec += host_nsec() - nsec_start;
+		filter.insns += host_instructions() - insns_start;
+		filter.calls += BENCH_SAMPLES;
+	}
+
+	print_acc("touch", "filter_touch", &filter);
+}
+
+int main(void)
+{
+	ticks_since_startup = 0;
+
+	bench_update_fsm();
+	bench_fade_functions();
+	bench_filter_touch();
+
+	return (0);
+}
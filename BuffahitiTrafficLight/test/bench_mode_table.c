@@ -0,0 +1,246 @@
+/**
+ * \file    bench_mode_table.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Microbenchmark of mode_table against the switch statements it replaced. The switch
+ * 			versions are kept here as they were, with their durations already in integer ticks, so
+ * 			only the dispatch differs. Prints one line per operation:
+ * 			mode_table,<operation>,<switch insns per call>,<table insns per call>,<switch ns per call>,<table ns per call>
+ * 			Instruction counts are of the host CPU, so only their ratio carries over to the target
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * User-defined libraries
+ */
+#include "fsm_trafficlight.h"
+#include "host.h"
+#include "systick.h"
+
+/**
+ * \def		BENCH_CALLS
+ * \brief	Calls timed per operation and version
+ */
+#define BENCH_CALLS\
+	(4000000UL)
+
+/**
+ * \typedef	bench_fn_t
+ * \brief	One operation on one mode, returning something so it can't be optimized away
+ */
+typedef uint32_t (*bench_fn_t)(mode_t mode, uint32_t ticks);
+
+/**
+ * \var		volatile uint32_t bench_sink
+ * \brief	Where every result goes
+ */
+static volatile uint32_t bench_sink;
+
+/**
+ * \fn		uint32_t switch_enough_time_stable
+ * \brief	The per-tick dwell check as a switch on the mode
+ */
+static __attribute__((noinline)) uint32_t switch_enough_time_stable(mode_t mode, uint32_t ticks)
+{
+	bool return_value = false;
+
+	switch(mode){
+	case STOP:
+		return_value = (ticks >= SEC_TO_TICKS(SEC_PER_STOP));
+		break;
+	case GO:
+		return_value = (ticks >= SEC_TO_TICKS(SEC_PER_GO));
+		break;
+	case WARNING:
+		return_value = (ticks >= SEC_TO_TICKS(SEC_PER_WARNING));
+		break;
+	case CROSSWALK:
+		return_value = (ticks >= SEC_TO_TICKS(SEC_PER_CROSSWALK));
+		break;
+	default:
+		break;
+	}
+
+	return (return_value);
+}
+
+/**
+ * \fn		uint32_t table_enough_time_stable
+ * \brief	The per-tick dwell check as one load from mode_table
+ */
+static __attribute__((noinline)) uint32_t table_enough_time_stable(mode_t mode, uint32_t ticks)
+{
+	return (ticks >= mode_table[mode].dwell_ticks);
+}
+
+/**
+ * \fn		uint32_t switch_next_state
+ * \brief	transition_state()'s choice of the next mode and its levels as a switch on the mode
+ */
+static __attribute__((noinline)) uint32_t switch_next_state(mode_t mode, uint32_t ticks)
+{
+	state_t next;
+
+	switch(mode){
+	case STOP:
+		next.mode = GO;
+		next.red_level = GO_RED_LEVEL;
+		next.green_level = GO_GREEN_LEVEL;
+		next.blue_level = GO_BLUE_LEVEL;
+		break;
+	case GO:
+		next.mode = WARNING;
+		next.red_level = WARNING_RED_LEVEL;
+		next.green_level = WARNING_GREEN_LEVEL;
+		next.blue_level = WARNING_BLUE_LEVEL;
+		break;
+	case WARNING:
+		next.mode = STOP;
+		next.red_level = STOP_RED_LEVEL;
+		next.green_level = STOP_GREEN_LEVEL;
+		next.blue_level = STOP_BLUE_LEVEL;
+		break;
+	case CROSSWALK:
+	default:
+		next.mode = GO;
+		next.red_level = GO_RED_LEVEL;
+		next.green_level = GO_GREEN_LEVEL;
+		next.blue_level = GO_BLUE_LEVEL;
+		break;
+	}
+
+	return ((uint32_t)next.mode ^ next.red_level ^ ((uint32_t)next.green_level << 8) ^ ((uint32_t)next.blue_level << 16));
+}
+
+/**
+ * \fn		uint32_t table_next_state
+ * \brief	transition_state()'s choice of the next mode and its levels from mode_table
+ */
+static __attribute__((noinline)) uint32_t table_next_state(mode_t mode, uint32_t ticks)
+{
+	const mode_desc_t *entry = &mode_table[mode_table[mode].next_mode];
+
+	return ((uint32_t)mode_table[mode].next_mode ^ entry->red_level ^ ((uint32_t)entry->green_level << 8) ^ ((uint32_t)entry->blue_level << 16));
+}
+
+/**
+ * \fn		uint32_t switch_mode_to_string
+ * \brief	mode_to_string() as a switch on the mode
+ */
+static __attribute__((noinline)) uint32_t switch_mode_to_string(mode_t mode, uint32_t ticks)
+{
+	const char *return_value;
+
+	switch(mode){
+	case STOP:
+		return_value = "STOP";
+		break;
+	case GO:
+		return_value = "GO";
+		break;
+	case WARNING:
+		return_value = "WARNING";
+		break;
+	case CROSSWALK:
+		return_value = "CROSSWALK";
+		break;
+	default:
+		return_value = "UNKNOWN";
+		break;
+	}
+
+	return ((uint32_t)(uintptr_t)return_value);
+}
+
+/**
+ * \fn		uint32_t table_mode_to_string
+ * \brief	mode_to_string() as it is now
+ */
+static __attribute__((noinline)) uint32_t table_mode_to_string(mode_t mode, uint32_t ticks)
+{
+	return ((uint32_t)(uintptr_t)mode_to_string(mode));
+}
+
+/**
+ * \fn		void bench
+ * \param	bench_fn_t fn The version to time
+ * \param	uint64_t *insns Receives host instructions per call
+ * \param	uint64_t *nsec Receives ns per call, in hundredths
+ * \return	N/A
+ * \brief   Call fn BENCH_CALLS times, walking through the modes in FSM order and the ticks of a
+ * 			dwell the way the old main loop did
+ */
+static void bench(bench_fn_t fn, uint64_t *insns, uint64_t *nsec)
+{
+	uint64_t insns_start;
+	uint64_t nsec_start;
+	uint32_t call;
+	uint32_t ticks = 0;
+	mode_t mode = STOP;
+
+	insns_start = host_instructions();
+	nsec_start = host_nsec();
+
+	for(call = 0; call < BENCH_CALLS; call++){
+		bench_sink += fn(mode, ticks);
+
+		if(++ticks > mode_table[mode].dwell_ticks){
+			ticks = 0;
+			mode = mode_table[mode].next_mode;
+		}
+	}
+
+	*nsec = ((host_nsec() - nsec_start) * 100) / BENCH_CALLS;
+	*insns = (host_instructions() - insns_start) / BENCH_CALLS;
+}
+
+/**
+ * \fn		void bench_pair
+ * \param	const char *operation Name printed for the operation
+ * \param	bench_fn_t switch_fn The switch version
+ * \param	bench_fn_t table_fn The mode_table version
+ * \return	N/A
+ * \brief   Time both versions and print them side by side
+ */
+static void bench_pair(const char *operation, bench_fn_t switch_fn, bench_fn_t table_fn)
+{
+	uint64_t switch_insns;
+	uint64_t table_insns;
+	uint64_t switch_nsec;
+	uint64_t table_nsec;
+
+	bench(switch_fn, &switch_insns, &switch_nsec);
+	bench(table_fn, &table_insns, &table_nsec);
+
+	printf("mode_table,%s,%llu,%llu,%llu.%02llu,%llu.%02llu\n",
+		operation,
+		(unsigned long long)switch_insns,
+		(unsigned long long)table_insns,
+		(unsigned long long)(switch_nsec / 100), (unsigned long long)(switch_nsec % 100),
+		(unsigned long long)(table_nsec / 100), (unsigned long long)(table_nsec % 100));
+}
+
+int main(void)
+{
+	mode_t mode;
+	int failures = 0;
+
+    /**
+     * Both versions have to agree before their timing means anything
+     */
+	for(mode = STOP; mode < NUM_MODES; mode++){
+		failures += (switch_next_state(mode, 0) != table_next_state(mode, 0));
+		failures += (switch_enough_time_stable(mode, mode_table[mode].dwell_ticks) != 1);
+		failures += (switch_enough_time_stable(mode, mode_table[mode].dwell_ticks - 1) != 0);
+		failures += (table_enough_time_stable(mode, mode_table[mode].dwell_ticks - 1) != 0);
+	}
+
+	bench_pair("enough_time_stable", switch_enough_time_stable, table_enough_time_stable);
+	bench_pair("next_state", switch_next_state, table_next_state);
+	bench_pair("mode_to_string", switch_mode_to_string, table_mode_to_string);
+
+	return (failures != 0);
+}
@@ -0,0 +1,382 @@
+/**
+ * \file    replay_recording.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host replay of recorder dumps. Given the output of the 'r' console command saved to a
+ * 			file, replays it through the FSM and prints every LED update:
+ * 			output,<tick>,<mode>,<red>,<green>,<blue>,<lit>
+ * 			Without a file, records a live run with touches polled both in and after update_fsm(),
+ * 			dumps it, replays the dump and checks every LED update matches the live run's:
+ * 			replay,<live ticks>,<records>,<replayed ticks>,<outputs compared>,<late touches>,<mismatches>
+ * 			usage: replay_recording [dump file]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * User-defined libraries
+ */
+#include "fsl_debug_console.h"
+#include "fsm_trafficlight.h"
+#include "recorder.h"
+#include "swtimer.h"
+#include "systick.h"
+#include "touch.h"
+#include "touch_filter.h"
+
+/**
+ * \def		LIVE_TICKS
+ * \brief	Length of the live run, long enough that the ring has wrapped many times
+ */
+#define LIVE_TICKS\
+	(SEC_TO_TICKS(60UL * 60))
+
+/**
+ * \def		MAX_OUTPUTS
+ * \brief	LED updates logged per run at most
+ */
+#define MAX_OUTPUTS\
+	(1UL << 20)
+
+/**
+ * \def		PRESS_SAMPLES
+ * \brief	Samples each press lasts
+ */
+#define PRESS_SAMPLES\
+	(6)
+
+/**
+ * \typedef	output_log_t
+ * \brief	To allow objects of struct output_log_s to be declared with ease
+ */
+typedef struct output_log_s output_log_t;
+
+/**
+ * \struct	output_log_s
+ * \brief	One LED update, and the tick it was made on
+ */
+struct output_log_s {
+	ticktime_t tick;
+	state_t state;
+	bool lit;
+};
+
+/**
+ * \var		output_log_t live_log[MAX_OUTPUTS], replay_log[MAX_OUTPUTS]
+ * \brief	LED updates of the live run and of its replay
+ */
+static output_log_t live_log[MAX_OUTPUTS];
+static output_log_t replay_log[MAX_OUTPUTS];
+
+/**
+ * \var		uint32_t live_outputs, replay_outputs
+ * \brief	Number of updates in each log
+ */
+static uint32_t live_outputs;
+static uint32_t replay_outputs;
+
+/**
+ * \var		record_t loaded[RECORDER_DEPTH]
+ * \brief	Records parsed from a dump
+ */
+static record_t loaded[RECORDER_DEPTH];
+
+/**
+ * \var		uint32_t seed
+ * \brief	State of the live run's pseudo-random generator
+ */
+static uint32_t seed = 2463534242UL;
+
+/**
+ * \var		touch_filter_t live_filter
+ * \brief	Touch pipeline of the live run
+ */
+static touch_filter_t live_filter;
+
+/**
+ * \var		bool live_scanned
+ * \brief	True if the live run's next sample has a new scan to take
+ */
+static bool live_scanned;
+
+/**
+ * \var		uint32_t live_samples, next_press
+ * \brief	Samples taken so far by the live run, and the sample the next press starts on
+ */
+static uint32_t live_samples;
+static uint32_t next_press = 100;
+
+/**
+ * \fn		uint32_t next_random
+ * \param	N/A
+ * \return	The next pseudo-random value
+ * \brief   xorshift32, so the live run is reproducible
+ */
+static uint32_t next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return (seed);
+}
+
+/**
+ * \fn		void log_output
+ * \param	output_log_t *log The log
+ * \param	uint32_t *outputs Number of updates in it
+ * \param	const trafficlight_t *tl The traffic light
+ * \param	bool lit Whether the LEDs are lit
+ * \return	N/A
+ * \brief   Append one LED update
+ */
+static void log_output(output_log_t *log, uint32_t *outputs, const trafficlight_t *tl, bool lit)
+{
+	if(*outputs < MAX_OUTPUTS){
+		log[*outputs].tick = ticks_since_startup;
+		log[*outputs].state = tl->current;
+		log[*outputs].lit = lit;
+		(*outputs)++;
+	}
+}
+
+/**
+ * \fn		void live_output, replay_output
+ * \param	const trafficlight_t *tl The traffic light
+ * \param	bool lit Whether the LEDs are lit
+ * \return	N/A
+ * \brief   led_output_t of the live and the replayed traffic light
+ */
+static void live_output(const trafficlight_t *tl, bool lit)
+{
+	log_output(live_log, &live_outputs, tl, lit);
+}
+
+static void replay_output(const trafficlight_t *tl, bool lit)
+{
+	log_output(replay_log, &replay_outputs, tl, lit);
+}
+
+/**
+ * \fn		bool live_input
+ * \param	void *context Unused
+ * \return	Returns true if the new scan reads as a touch
+ * \brief   touch_input_t of the live run. Like touchpad_is_touched(), only a new scan goes through
+ * 			the pipeline and is recorded
+ */
+static bool live_input(void *context)
+{
+	bool return_value = false;
+	uint32_t raw;
+	uint32_t touch;
+
+	if(live_scanned){
+		live_scanned = false;
+
+		if(live_samples == next_press + PRESS_SAMPLES){
+			next_press = live_samples + 1 + (next_random() % SEC_TO_TICKS(40));
+		}
+
+		raw = 1000 + (next_random() % 21);
+
+		if(live_samples >= next_press){
+			raw += 3 * MIN_TOUCH;
+		}
+
+		live_samples++;
+
+		touch = filter_touch(&live_filter, raw);
+		return_value = touch_detect(touch);
+		record_touch(touch);
+	}
+
+	return (return_value);
+}
+
+/**
+ * \fn		bool same_state
+ * \param	const state_t *a One state
+ * \param	const state_t *b The other
+ * \return	Returns true if they show the same mode and colour
+ * \brief   Compared member by member, since padding is not
+ */
+static bool same_state(const state_t *a, const state_t *b)
+{
+	return ((a->mode == b->mode) &&
+		(a->red_level == b->red_level) &&
+		(a->green_level == b->green_level) &&
+		(a->blue_level == b->blue_level));
+}
+
+/**
+ * \fn		uint32_t parse_dump
+ * \param	FILE *dump The output of dump_recording()
+ * \param	uint32_t *first_tick Receives the tick of the first record
+ * \return	Number of records parsed into loaded
+ * \brief   Read a dump back, ignoring any other lines the console printed around it
+ */
+static uint32_t parse_dump(FILE *dump, uint32_t *first_tick)
+{
+	char line[128];
+	uint32_t parsed = 0;
+	uint32_t total;
+	unsigned int kind;
+	unsigned int delta;
+	unsigned int value;
+
+	*first_tick = 0;
+
+	while(fgets(line, sizeof(line), dump) != NULL){
+		if(sscanf(line, "recording,%u,%u", first_tick, &total) == 2){
+			parsed = 0;
+		}
+		else if(sscanf(line, "record,%u,%u,%u", &kind, &delta, &value) == 3 && parsed < RECORDER_DEPTH){
+			loaded[parsed].kind = (uint8_t)kind;
+			loaded[parsed].delta = (uint8_t)delta;
+			loaded[parsed].value = (uint16_t)value;
+			parsed++;
+		}
+	}
+
+	return (parsed);
+}
+
+/**
+ * \fn		int replay_file
+ * \param	const char *path A saved dump
+ * \return	0, or 1 if the file can't be read or has no checkpoint
+ * \brief   Replay a dump from the board up to its newest record and print every LED update
+ */
+static int replay_file(const char *path)
+{
+	FILE *dump = fopen(path, "r");
+	trafficlight_t replayed;
+	uint32_t first_tick;
+	uint32_t parsed;
+	uint32_t n;
+	int return_value = 1;
+
+	if(dump == NULL){
+		return (return_value);
+	}
+
+	parsed = parse_dump(dump, &first_tick);
+	fclose(dump);
+
+	load_recording(first_tick, loaded, (uint16_t)parsed);
+
+	ticks_since_startup = first_tick;
+
+	for(n = 1; n < parsed; n++){
+		ticks_since_startup += loaded[n].delta;
+	}
+
+	if(replay_recording(&replayed, replay_output) > 0){
+		for(n = 0; n < replay_outputs; n++){
+			printf("output,%u,%s,%u,%u,%u,%u\n",
+				replay_log[n].tick,
+				mode_to_string(replay_log[n].state.mode),
+				replay_log[n].state.red_level,
+				replay_log[n].state.green_level,
+				replay_log[n].state.blue_level,
+				replay_log[n].lit);
+		}
+
+		return_value = 0;
+	}
+
+	return (return_value);
+}
+
+/**
+ * \fn		int replay_live
+ * \param	N/A
+ * \return	0, or 1 if the replay differs from the live run
+ * \brief   Run the controller the way main.c does: a tick's update_fsm() may or may not find a new
+ * 			scan, and TASK_TOUCH may poll a few more before the next tick. Then dump, parse, load and
+ * 			replay the recording and compare the LED updates since its oldest checkpoint
+ */
+static int replay_live(void)
+{
+	trafficlight_t live;
+	trafficlight_t replayed;
+	swtimer_wheel_t live_timers;
+	uint32_t late_touches = 0;
+	uint32_t mismatches = 0;
+	uint32_t replayed_ticks;
+	uint32_t first_tick;
+	uint32_t parsed;
+	uint32_t tail;
+	uint32_t late;
+	uint32_t n;
+
+	ticks_since_startup = 0;
+	init_touch_filter(&live_filter, 1000, 5);
+	init_swtimer_wheel(&live_timers, ticks_since_startup);
+	init_fsm_trafficlight(&live, &live_timers, live_input, NULL, live_output);
+	init_recorder(&live);
+
+	while(ticks_since_startup < LIVE_TICKS){
+		ticks_since_startup++;
+
+		live_scanned = (next_random() % 4) != 0;
+		update_fsm(&live);
+		record_checkpoint(&live);
+
+		for(late = next_random() % 4; late > 0; late--){
+			live_scanned = true;
+			late_touches += poll_touch(&live);
+		}
+	}
+
+    /**
+     * Round trip the recording through the console format
+     */
+	host_console = tmpfile();
+
+	if(host_console == NULL){
+		return (1);
+	}
+
+	dump_recording();
+	rewind(host_console);
+	parsed = parse_dump(host_console, &first_tick);
+	fclose(host_console);
+	host_console = NULL;
+
+	load_recording(first_tick, loaded, (uint16_t)parsed);
+	replayed_ticks = replay_recording(&replayed, replay_output);
+
+    /**
+     * The replay has to make exactly the updates the live run made after its oldest checkpoint,
+     * and end in the same state
+     */
+	tail = live_outputs - replay_outputs;
+
+	if((replayed_ticks == 0) || (replay_outputs > live_outputs) ||
+		((tail > 0) && (live_log[tail - 1].tick > LIVE_TICKS - replayed_ticks))){
+		mismatches++;
+	}
+	else{
+		for(n = 0; n < replay_outputs; n++){
+			mismatches += (live_log[tail + n].tick != replay_log[n].tick) ||
+				(live_log[tail + n].lit != replay_log[n].lit) ||
+				!same_state(&live_log[tail + n].state, &replay_log[n].state);
+		}
+	}
+
+	mismatches += !same_state(&live.current, &replayed.current);
+	mismatches += (live.transitioning != replayed.transitioning);
+
+	printf("replay,%u,%u,%u,%u,%u,%u\n", (uint32_t)LIVE_TICKS, parsed, replayed_ticks, replay_outputs, late_touches, mismatches);
+
+	return (mismatches != 0);
+}
+
+int main(int argc, char **argv)
+{
+	return ((argc > 1) ? replay_file(argv[1]) : replay_live());
+}
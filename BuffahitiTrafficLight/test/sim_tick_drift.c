@@ -0,0 +1,298 @@
+/**
+ * \file    sim_tick_drift.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host simulation of the tick rate over SIM_HOURS, running systick.c against the SysTick
+ * 			model in host_systick.c. The main loop is modelled on main.c: it takes every EVENT_TICK
+ * 			and catches up to the tick it carries one tick at a time, then works for a while, now and
+ * 			then stalling for several ticks as a blocking console print would. The switching run
+ * 			also moves between RUN and VLPR as idle_run_mode() does. Every tick raised has to be
+ * 			processed, and no tick may be raised further than TICK_CLOCKS_MAX counter clocks from
+ * 			where an exact 1 / TICK_HZ sec puts it, however long it runs. Prints one line per run:
+ * 			tick_drift,<run>,<tick hz>,<ticks>,<switches>,<stalls>,<most caught up>,<lost ticks>,<earliest ns>,<latest ns>,<final ns>
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "core_cm0plus.h"
+
+/**
+ * User-defined libraries
+ */
+#include "event.h"
+#include "systick.h"
+
+/**
+ * \def		SIM_HOURS
+ * \brief	Simulated time per run
+ */
+#define SIM_HOURS\
+	(24)
+
+/**
+ * \def		STALL_EVERY
+ * \brief	One main loop pass in about this many stalls for STALL_TICKS_MAX ticks or fewer
+ */
+#define STALL_EVERY\
+	(256)
+
+/**
+ * \def		STALL_TICKS_MAX
+ * \brief	Most whole ticks a stall lasts, e.g. a long PRINTF at console baud plus a TSI scan
+ */
+#define STALL_TICKS_MAX\
+	(4)
+
+/**
+ * \def		SWITCH_EVERY
+ * \brief	In the switching run, the clock switches on average once every this many passes
+ */
+#define SWITCH_EVERY\
+	(4)
+
+/**
+ * \def		TICK_CLOCKS_MAX
+ * \brief	Furthest a tick may be raised from exact in the switching run, in VLPR counter clocks:
+ * 			one for planning in whole clocks, one for a switch rounding the running period down
+ * 			(only the period after the one already planned repays it) and one for another switch
+ * 			coming first. Without switching, a tick is within one count
+ */
+#define TICK_CLOCKS_MAX\
+	(3)
+
+/**
+ * \def		NSEC_PER_SEC
+ * \brief	Nanoseconds in a second, for printing drift
+ */
+#define NSEC_PER_SEC\
+	(1000000000LL)
+
+/**
+ * \typedef	drift_run_t
+ * \brief	To allow objects of struct drift_run_s to be declared with ease
+ */
+typedef struct drift_run_s drift_run_t;
+
+/**
+ * \struct	drift_run_s
+ * \brief	What one run found. Drift is how far a tick was raised after where an exact
+ * 			1 / TICK_HZ sec puts it, in units of 1 / TICK_HZ count
+ */
+struct drift_run_s {
+	uint32_t switches;
+	uint32_t stalls;
+	uint32_t most_caught_up;
+	int64_t earliest;
+	int64_t latest;
+	int64_t final;
+};
+
+/**
+ * \var		uint32_t seed
+ * \brief	State of the pseudo-random generator
+ */
+static uint32_t seed = 2463534242UL;
+
+/**
+ * \fn		uint32_t next_random
+ * \param	N/A
+ * \return	The next pseudo-random value
+ * \brief   xorshift32, so every run is reproducible
+ */
+static uint32_t next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return (seed);
+}
+
+/**
+ * \fn		void run_counter
+ * \param	uint32_t counts SysTick counts to let pass
+ * \return	N/A
+ * \brief   Let time pass in the main loop. Interrupts stay enabled, so SysTick_Handler() is taken
+ * 			straight after every reload, however long the main loop is busy
+ */
+static void run_counter(uint32_t counts)
+{
+	uint32_t clocks = counts / host_systick_scale;
+	uint32_t chunk;
+
+	host_systick_delay = 0;
+
+	while(clocks > 0){
+		chunk = SYSTICK_PERIOD_COUNTS / (4 * host_systick_scale);
+		chunk = (clocks < chunk) ? clocks : chunk;
+		clocks -= chunk;
+
+	    /**
+	     * Take anything pending first, so SysTick_Handler()'s own accesses don't run the chunk too
+	     */
+		host_systick_step = 0;
+		(void)SCB;
+
+		host_systick_step = chunk;
+		(void)SCB;
+	}
+
+	host_systick_step = 0;
+	(void)SCB;
+}
+
+/**
+ * \fn		void switch_clock
+ * \param	uint32_t scale SysTick counts per counter clock in the new mode
+ * \return	N/A
+ * \brief   Pause and resume SysTick around a clock switch as idle_run_mode() does, with
+ * 			interrupts masked
+ */
+static void switch_clock(uint32_t scale)
+{
+	host_systick_masked = true;
+	host_systick_step = 1;
+
+	systick_pause();
+	host_systick_scale = scale;
+	(void)systick_resume(scale, 0);
+
+	host_systick_masked = false;
+}
+
+/**
+ * \fn		void check_drift
+ * \param	drift_run_t *run Receives the drift of the latest tick
+ * \return	N/A
+ * \brief   Compare when the latest tick was raised with where systick_wraps exact ticks end
+ */
+static void check_drift(drift_run_t *run)
+{
+	int64_t drift = (int64_t)(host_systick_reached * TICK_HZ) - (int64_t)(systick_wraps * ALT_CLOCK_HZ);
+
+	if(drift < run->earliest){
+		run->earliest = drift;
+	}
+
+	if(drift > run->latest){
+		run->latest = drift;
+	}
+
+	run->final = drift;
+}
+
+/**
+ * \fn		int64_t drift_ns
+ * \param	int64_t drift Drift in units of 1 / TICK_HZ count
+ * \return	The same drift in ns
+ * \brief   For printing
+ */
+static int64_t drift_ns(int64_t drift)
+{
+	return ((drift * NSEC_PER_SEC) / ((int64_t)TICK_HZ * (int64_t)ALT_CLOCK_HZ));
+}
+
+/**
+ * \fn		uint32_t sim_run
+ * \param	const char *name Name printed for the run
+ * \param	bool switching True to switch between RUN and VLPR now and then
+ * \return	Number of failures
+ * \brief   Run the main loop for SIM_HOURS more
+ */
+static uint32_t sim_run(const char *name, bool switching)
+{
+	drift_run_t run = {0};
+	uint64_t end = systick_wraps + (uint64_t)SIM_HOURS * 3600 * TICK_HZ;
+	uint64_t start = systick_wraps;
+	ticktime_t tick_target = ticks_since_startup;
+	uint32_t caught_up;
+	uint32_t lost;
+	int64_t bound;
+	event_t event;
+
+	while(systick_wraps < end){
+
+	    /**
+	     * Take every tick raised and catch up to the latest one, as fsm_task() does
+	     */
+		while(event_take(&event)){
+			if(event.kind == EVENT_TICK){
+				tick_target = event.arg;
+			}
+		}
+
+		caught_up = 0;
+
+		while(!TICKS_REACHED(ticks_since_startup, tick_target)){
+			ticks_since_startup++;
+			caught_up++;
+		}
+
+		if(caught_up > run.most_caught_up){
+			run.most_caught_up = caught_up;
+		}
+
+		if(switching && (next_random() % SWITCH_EVERY == 0)){
+			switch_clock((host_systick_scale == 1) ? SYSTICK_VLPR_SCALE : 1);
+			run.switches++;
+		}
+
+	    /**
+	     * Work for up to a tick, or now and then stall for several
+	     */
+		if(next_random() % STALL_EVERY == 0){
+			run_counter((1 + (next_random() % STALL_TICKS_MAX)) * SYSTICK_PERIOD_COUNTS);
+			run.stalls++;
+		}
+		else{
+			run_counter(next_random() % SYSTICK_PERIOD_COUNTS);
+		}
+
+		check_drift(&run);
+	}
+
+	while(event_take(&event)){
+		if(event.kind == EVENT_TICK){
+			tick_target = event.arg;
+		}
+	}
+
+	while(!TICKS_REACHED(ticks_since_startup, tick_target)){
+		ticks_since_startup++;
+	}
+
+	lost = (uint32_t)(systick_wraps - ticks_since_startup);
+
+	printf("tick_drift,%s,%u,%llu,%u,%u,%u,%u,%lld,%lld,%lld\n",
+		name,
+		TICK_HZ,
+		(unsigned long long)(systick_wraps - start),
+		run.switches,
+		run.stalls,
+		run.most_caught_up,
+		lost,
+		(long long)drift_ns(run.earliest),
+		(long long)drift_ns(run.latest),
+		(long long)drift_ns(run.final));
+
+    /**
+     * In units of 1 / TICK_HZ count, either way
+     */
+	bound = (int64_t)TICK_HZ * (switching ? (TICK_CLOCKS_MAX * SYSTICK_VLPR_SCALE) : 1);
+
+	return (lost + (run.earliest < -bound) + (run.latest > bound));
+}
+
+int main(void)
+{
+	uint32_t failures = 0;
+
+	init_onboard_systick();
+
+	failures += sim_run("run", false);
+	failures += sim_run("switching", true);
+
+	return (failures != 0);
+}
@@ -0,0 +1,275 @@
+/**
+ * \file    sim_trafficlight.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Virtual-time simulator of many traffic lights side by side. Each light runs the
+ * 			unmodified FSM with its own wheel and its own simulated pedestrian, and every state
+ * 			change is checked against mode_table. Time jumps straight to the next tick on which some
+ * 			light has work, so days of controller time take seconds. Prints:
+ * 			sim,<lights>,<days>,<ticks>,<updates>,<outputs>,<violations>,<wall ms>,<sim ticks per sec>
+ * 			usage: sim_trafficlight [lights] [days]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * User-defined libraries
+ */
+#include "fsm_trafficlight.h"
+#include "host.h"
+#include "swtimer.h"
+#include "systick.h"
+
+/**
+ * \def		SIM_DEFAULT_LIGHTS
+ * \brief	Number of lights simulated unless given on the command line
+ */
+#define SIM_DEFAULT_LIGHTS\
+	(100)
+
+/**
+ * \def		SIM_MAX_PRESS_GAP
+ * \brief	Longest gap in ticks between one pedestrian's presses. Gaps are uniform up to this, so
+ * 			about one press every two minutes
+ */
+#define SIM_MAX_PRESS_GAP\
+	(SEC_TO_TICKS(240))
+
+/**
+ * \typedef	pedestrian_t
+ * \brief	To allow objects of struct pedestrian_s to be declared with ease
+ */
+typedef struct pedestrian_s pedestrian_t;
+
+/**
+ * \typedef	sim_light_t
+ * \brief	To allow objects of struct sim_light_s to be declared with ease
+ */
+typedef struct sim_light_s sim_light_t;
+
+/**
+ * \struct	pedestrian_s
+ * \brief	The input of one light: presses at pseudo-random ticks of its own
+ */
+struct pedestrian_s {
+	uint32_t seed;
+	ticktime_t next_press;
+	ticktime_t pressed_at;
+	bool pressed;
+};
+
+/**
+ * \struct	sim_light_s
+ * \brief	One simulated light, its pedestrian, and what the checks remember about it
+ */
+struct sim_light_s {
+	trafficlight_t tl;
+	swtimer_wheel_t wheel;
+	swtimer_t wake;
+	pedestrian_t pedestrian;
+	ticktime_t stable_since;
+	ticktime_t transition_since;
+	uint32_t outputs;
+};
+
+/**
+ * \var		swtimer_wheel_t sim_schedule
+ * \brief	Wakes each light on the next tick it has work. The simulation only visits ticks on
+ * 			which some light's wake timer expires
+ */
+static swtimer_wheel_t sim_schedule;
+
+/**
+ * \var		uint64_t sim_updates, sim_violations
+ * \brief	Calls to update_fsm() and failed checks, over every light
+ */
+static uint64_t sim_updates;
+static uint64_t sim_violations;
+
+/**
+ * \fn		uint32_t next_random
+ * \param	uint32_t *seed The generator's state
+ * \return	The next pseudo-random value
+ * \brief   xorshift32, so each pedestrian is reproducible on its own
+ */
+static uint32_t next_random(uint32_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+
+	return (*seed);
+}
+
+/**
+ * \fn		bool pedestrian_input
+ * \param	void *context The light's pedestrian_t
+ * \return	Returns true on the tick of a press
+ * \brief   touch_input_t of every simulated light
+ */
+static bool pedestrian_input(void *context)
+{
+	pedestrian_t *pedestrian = context;
+	bool return_value = false;
+
+	if(TICKS_REACHED(ticks_since_startup, pedestrian->next_press)){
+		pedestrian->next_press = ticks_since_startup + 1 + (next_random(&pedestrian->seed) % SIM_MAX_PRESS_GAP);
+		pedestrian->pressed_at = ticks_since_startup;
+		pedestrian->pressed = true;
+		return_value = true;
+	}
+
+	return (return_value);
+}
+
+/**
+ * \fn		void count_output
+ * \param	const trafficlight_t *tl The light whose colour changed
+ * \param	bool lit Unused
+ * \return	N/A
+ * \brief   led_output_t of every simulated light. tl is the first member of its sim_light_t
+ */
+static void count_output(const trafficlight_t *tl, bool lit)
+{
+	((sim_light_t *)tl)->outputs++;
+}
+
+/**
+ * \fn		void check
+ * \param	bool ok The condition
+ * \param	const char *what What went wrong if it is false
+ * \return	N/A
+ * \brief   Count a failed check and print the first few
+ */
+static void check(bool ok, const char *what)
+{
+	if(!ok){
+		if(sim_violations < 10){
+			printf("violation,%u,%s\n", ticks_since_startup, what);
+		}
+
+		sim_violations++;
+	}
+}
+
+/**
+ * \fn		void wake_light
+ * \param	void *arg The sim_light_t due
+ * \return	N/A
+ * \brief   Run one light on this tick, check what it did against mode_table, and schedule its next
+ * 			wake at its next timer or press, whichever is sooner
+ */
+static void wake_light(void *arg)
+{
+	sim_light_t *light = arg;
+	trafficlight_t *tl = &light->tl;
+	mode_t mode = tl->current.mode;
+	bool transitioning = tl->transitioning;
+	const mode_desc_t *entry;
+	ticktime_t next;
+
+	light->pedestrian.pressed = false;
+
+	update_fsm(tl);
+	sim_updates++;
+
+	entry = &mode_table[tl->current.mode];
+
+    /**
+     * A press outside of CROSSWALK starts a transition to it straight away. Otherwise a transition
+     * starts exactly when the dwell of the mode is over and heads for its next mode, and ends
+     * TICKS_PER_TRANSITION later on the new mode's levels
+     */
+	if(light->pedestrian.pressed && (mode != CROSSWALK)){
+		check(tl->transitioning && (tl->current.mode == CROSSWALK), "press did not start CROSSWALK");
+		light->transition_since = ticks_since_startup;
+	}
+	else if(!transitioning && tl->transitioning){
+		check(tl->current.mode == mode_table[mode].next_mode, "wrong next mode");
+		check(ticks_since_startup - light->stable_since == mode_table[mode].dwell_ticks, "wrong dwell");
+		light->transition_since = ticks_since_startup;
+	}
+	else if(transitioning && !tl->transitioning){
+		check(ticks_since_startup - light->transition_since == TICKS_PER_TRANSITION, "wrong transition length");
+		check((tl->current.red_level == entry->red_level) &&
+			(tl->current.green_level == entry->green_level) &&
+			(tl->current.blue_level == entry->blue_level), "fade missed its target");
+		light->stable_since = ticks_since_startup;
+	}
+	else{
+		check(tl->current.mode == mode, "mode changed without a transition");
+	}
+
+	next = ticks_since_startup + swtimer_quiet_ticks(&light->wheel);
+
+	if(!TICKS_REACHED(light->pedestrian.next_press, next)){
+		next = light->pedestrian.next_press;
+	}
+
+	start_swtimer(&sim_schedule, &light->wake, next);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t lights = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : SIM_DEFAULT_LIGHTS;
+	uint32_t days = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 1;
+	ticktime_t end = days * SEC_TO_TICKS(24UL * 60 * 60);
+	sim_light_t *light_array = calloc(lights, sizeof(sim_light_t));
+	sim_light_t *light;
+	uint64_t outputs = 0;
+	uint64_t start;
+	uint64_t wall_nsec;
+	uint32_t n;
+
+	if(light_array == NULL){
+		return (1);
+	}
+
+	ticks_since_startup = 0;
+	init_swtimer_wheel(&sim_schedule, ticks_since_startup);
+
+	for(n = 0; n < lights; n++){
+		light = &light_array[n];
+		light->pedestrian.seed = 2463534242UL + n;
+		light->pedestrian.next_press = 1 + (next_random(&light->pedestrian.seed) % SIM_MAX_PRESS_GAP);
+
+		init_swtimer_wheel(&light->wheel, ticks_since_startup);
+		init_fsm_trafficlight(&light->tl, &light->wheel, pedestrian_input, &light->pedestrian, count_output);
+
+		init_swtimer(&light->wake, wake_light, light);
+		start_swtimer(&sim_schedule, &light->wake, ticks_since_startup + 1);
+	}
+
+	start = host_nsec();
+
+    /**
+     * Jump from one tick with work to the next
+     */
+	while(!TICKS_REACHED(ticks_since_startup, end)){
+		ticks_since_startup += swtimer_quiet_ticks(&sim_schedule);
+		advance_swtimers(&sim_schedule, ticks_since_startup);
+	}
+
+	wall_nsec = host_nsec() - start;
+
+	for(n = 0; n < lights; n++){
+		outputs += light_array[n].outputs;
+	}
+
+	printf("sim,%u,%u,%u,%llu,%llu,%llu,%llu,%.0f\n",
+		lights,
+		days,
+		end,
+		(unsigned long long)sim_updates,
+		(unsigned long long)outputs,
+		(unsigned long long)sim_violations,
+		(unsigned long long)(wall_nsec / 1000000),
+		(double)lights * end * 1e9 / (double)(wall_nsec ? wall_nsec : 1));
+
+	free(light_array);
+
+	return (sim_violations != 0);
+}
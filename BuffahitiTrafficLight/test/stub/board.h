@@ -0,0 +1,147 @@
+/**
+ * \file    board.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host stand-in for the board and device headers. Every peripheral is a plain struct in
+ * 			RAM (defined in host_regs.c) with the same field names as MKL25Z4.h, so the firmware
+ * 			sources compile unchanged and a test can look at what they wrote. The TSI is the one
+ * 			that does something on its own, see host_tsi.c
+ */
+
+#ifndef BOARD_H_
+#define BOARD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * \typedef	TPM_Type
+ * \brief	Timer/PWM module
+ */
+typedef struct {
+	uint32_t SC;
+	uint32_t CNT;
+	uint32_t MOD;
+	struct {
+		uint32_t CnSC;
+		uint32_t CnV;
+	} CONTROLS[6];
+	uint32_t STATUS;
+	uint32_t CONF;
+} TPM_Type;
+
+/**
+ * \typedef	PORT_Type
+ * \brief	Pin control
+ */
+typedef struct {
+	uint32_t PCR[32];
+} PORT_Type;
+
+/**
+ * \typedef	GPIO_Type
+ * \brief	GPIO port
+ */
+typedef struct {
+	uint32_t PDOR;
+	uint32_t PSOR;
+	uint32_t PCOR;
+	uint32_t PTOR;
+	uint32_t PDIR;
+	uint32_t PDDR;
+} GPIO_Type;
+
+/**
+ * \typedef	SIM_Type
+ * \brief	System integration module, clock gates only
+ */
+typedef struct {
+	uint32_t SOPT2;
+	uint32_t SCGC5;
+	uint32_t SCGC6;
+} SIM_Type;
+
+/**
+ * \typedef	TSI_Type
+ * \brief	Touch sensing input
+ */
+typedef struct {
+	uint32_t GENCS;
+	uint32_t DATA;
+	uint32_t TSHD;
+} TSI_Type;
+
+/**
+ * \typedef	host_electrode_t
+ * \brief	What a scan of oscillations electrode oscillations reads, supplied by the test
+ */
+typedef uint32_t (*host_electrode_t)(uint32_t oscillations);
+
+extern TPM_Type host_tpm0;
+extern TPM_Type host_tpm2;
+extern PORT_Type host_portb;
+extern PORT_Type host_portd;
+extern GPIO_Type host_ptb;
+extern GPIO_Type host_ptd;
+extern SIM_Type host_sim;
+extern host_electrode_t host_electrode;
+
+/**
+ * \fn		TSI_Type *host_tsi
+ * \param	N/A
+ * \return	The TSI registers
+ * \brief   Defined in host_tsi.c. Finishes a software-triggered scan before handing the registers
+ * 			back, so the firmware finds it done on its next access
+ */
+TSI_Type *host_tsi(void);
+
+#define TPM0				(&host_tpm0)
+#define TPM2				(&host_tpm2)
+#define PORTB				(&host_portb)
+#define PORTD				(&host_portd)
+#define PTB					(&host_ptb)
+#define PTD					(&host_ptd)
+#define SIM					(&host_sim)
+#define TSI0				(host_tsi())
+
+#define SIM_SCGC5_PORTB_MASK		(0x400UL)
+#define SIM_SCGC5_PORTD_MASK		(0x1000UL)
+#define PORT_PCR_MUX_MASK			(0x700UL)
+#define PORT_PCR_MUX(x)				(((uint32_t)(x) << 8) & PORT_PCR_MUX_MASK)
+#define TPM_SC_TOIE_MASK			(0x40UL)
+#define TPM_SC_TOF_MASK				(0x80UL)
+#define SIM_SCGC5_TSI_MASK			(0x20UL)
+#define TSI_GENCS_OUTRGF_MASK		(0x80000000UL)
+#define TSI_GENCS_ESOR_MASK			(0x10000000UL)
+#define TSI_GENCS_MODE(x)			(((uint32_t)(x) << 24) & 0xF000000UL)
+#define TSI_GENCS_REFCHRG(x)		(((uint32_t)(x) << 21) & 0xE00000UL)
+#define TSI_GENCS_DVOLT(x)			(((uint32_t)(x) << 19) & 0x180000UL)
+#define TSI_GENCS_EXTCHRG(x)		(((uint32_t)(x) << 16) & 0x70000UL)
+#define TSI_GENCS_PS(x)				(((uint32_t)(x) << 13) & 0xE000UL)
+#define TSI_GENCS_NSCN_MASK			(0x1F00UL)
+#define TSI_GENCS_NSCN_SHIFT		(8)
+#define TSI_GENCS_NSCN(x)			(((uint32_t)(x) << TSI_GENCS_NSCN_SHIFT) & TSI_GENCS_NSCN_MASK)
+#define TSI_GENCS_TSIEN_MASK		(0x80UL)
+#define TSI_GENCS_TSIIEN_MASK		(0x40UL)
+#define TSI_GENCS_STPE_MASK			(0x20UL)
+#define TSI_GENCS_STM_MASK			(0x10UL)
+#define TSI_GENCS_SCNIP_MASK		(0x8UL)
+#define TSI_GENCS_EOSF_MASK			(0x4UL)
+#define TSI_DATA_TSICH(x)			(((uint32_t)(x) << 28) & 0xF0000000UL)
+#define TSI_DATA_SWTS_MASK			(0x400000UL)
+#define TSI_DATA_TSICNT_MASK		(0xFFFFUL)
+#define TSI_TSHD_THRESH(x)			(((uint32_t)(x) << 16) & 0xFFFF0000UL)
+#define TSI_TSHD_THRESL(x)			((uint32_t)(x) & 0xFFFFUL)
+#define TSI0_IRQn					(26)
+
+/**
+ * There is nothing to mask on the host, and the tests are single threaded
+ */
+#define __disable_irq()
+#define __enable_irq()
+#define __DMB()
+#define NVIC_SetPriority(irq, priority)
+#define NVIC_EnableIRQ(irq)
+
+#endif /* BOARD_H_ */
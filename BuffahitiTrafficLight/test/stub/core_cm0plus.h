@@ -0,0 +1,99 @@
+/**
+ * \file    core_cm0plus.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host stand-in for the CMSIS core header, SysTick and SCB only. Like the TSI, they are
+ * 			a model rather than plain RAM: every access to SysTick or SCB lets the counter run on
+ * 			and may take a pending SysTick interrupt first, see host_systick.c
+ */
+
+#ifndef CORE_CM0PLUS_H_
+#define CORE_CM0PLUS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * \typedef	SysTick_Type
+ * \brief	System timer
+ */
+typedef struct {
+	uint32_t CTRL;
+	uint32_t LOAD;
+	uint32_t VAL;
+	uint32_t CALIB;
+} SysTick_Type;
+
+/**
+ * \typedef	SCB_Type
+ * \brief	System control block, interrupt control only
+ */
+typedef struct {
+	uint32_t ICSR;
+} SCB_Type;
+
+/**
+ * \var		extern uint32_t host_systick_step
+ * \brief	Counter clocks that pass on every access to SysTick or SCB. Set by the test
+ */
+extern uint32_t host_systick_step;
+
+/**
+ * \var		extern uint32_t host_systick_delay
+ * \brief	Accesses a pending SysTick interrupt waits before it is taken. Set by the test
+ */
+extern uint32_t host_systick_delay;
+
+/**
+ * \var		extern bool host_systick_masked
+ * \brief	True while interrupts are masked, so a pending one stays pending. Set by the test
+ */
+extern bool host_systick_masked;
+
+/**
+ * \var		extern uint32_t host_systick_scale
+ * \brief	SysTick counts per counter clock, as systick_resume() was told. Set by the test
+ */
+extern uint32_t host_systick_scale;
+
+/**
+ * \var		extern uint64_t host_systick_elapsed
+ * \brief	SysTick counts the counter has run since it was first enabled
+ */
+extern uint64_t host_systick_elapsed;
+
+/**
+ * \var		extern uint64_t host_systick_reached
+ * \brief	host_systick_elapsed when the counter last reached 0 and raised its interrupt
+ */
+extern uint64_t host_systick_reached;
+
+/**
+ * \fn		SysTick_Type *host_systick
+ * \param	N/A
+ * \return	The SysTick registers
+ * \brief   Run the counter on, then hand the registers back
+ */
+SysTick_Type *host_systick(void);
+
+/**
+ * \fn		SCB_Type *host_scb
+ * \param	N/A
+ * \return	The SCB registers
+ * \brief   Run the counter on, then hand the registers back
+ */
+SCB_Type *host_scb(void);
+
+#define SysTick						(host_systick())
+#define SCB							(host_scb())
+
+#define SysTick_IRQn				(-1)
+#define SysTick_CTRL_ENABLE_Msk		(0x1UL)
+#define SysTick_CTRL_TICKINT_Msk	(0x2UL)
+#define SysTick_CTRL_CLKSOURCE_Pos	(2)
+#define SysTick_CTRL_COUNTFLAG_Msk	(0x10000UL)
+#define SysTick_LOAD_RELOAD_Msk		(0xFFFFFFUL)
+#define SCB_ICSR_PENDSTSET_Msk		(0x4000000UL)
+#define SCB_ICSR_PENDSTCLR_Msk		(0x2000000UL)
+
+#endif /* CORE_CM0PLUS_H_ */
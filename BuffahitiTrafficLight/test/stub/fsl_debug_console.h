@@ -0,0 +1,23 @@
+/**
+ * \file    fsl_debug_console.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host stand-in for the SDK debug console. PRINTF goes to host_console, which a test can
+ * 			point at a file to read back what the firmware printed
+ */
+
+#ifndef FSL_DEBUG_CONSOLE_H_
+#define FSL_DEBUG_CONSOLE_H_
+
+#include <stdio.h>
+
+/**
+ * \var		extern FILE *host_console
+ * \brief	Defined in host_regs.c. stdout unless a test changes it
+ */
+extern FILE *host_console;
+
+#define PRINTF(...)\
+	(fprintf(host_console ? host_console : stdout, __VA_ARGS__))
+
+#endif /* FSL_DEBUG_CONSOLE_H_ */
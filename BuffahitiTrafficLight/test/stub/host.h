@@ -0,0 +1,35 @@
+/**
+ * \file    host.h
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Virtual clock and benchmark counters shared by the host tests, in place of SysTick
+ */
+
+#ifndef HOST_H_
+#define HOST_H_
+
+/**
+ * \var		extern uint32_t host_counts
+ * \brief	Defined in host_clock.c. What systick_counts() returns. Tests move it on themselves
+ */
+extern uint32_t host_counts;
+
+/**
+ * \fn		uint64_t host_nsec
+ * \param	N/A
+ * \return	Monotonic wall-clock time of the host in ns
+ * \brief   For timing benchmarks and throughput
+ */
+uint64_t host_nsec(void);
+
+/**
+ * \fn		uint64_t host_instructions
+ * \param	N/A
+ * \return	User-mode instructions the host CPU has retired in this process so far, or 0 every time
+ * 			if the host does not allow counting them
+ * \brief   For benchmarks. The counts are of host instructions, so compare them with each other
+ * 			rather than with the Cortex-M0+
+ */
+uint64_t host_instructions(void);
+
+#endif /* HOST_H_ */
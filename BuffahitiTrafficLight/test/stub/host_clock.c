@@ -0,0 +1,78 @@
+/**
+ * \file    host_clock.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Virtual clock shared by the host tests, in place of systick.c
+ */
+
+/**
+ * clock_gettime() and perf_event_open() are not C99. Only this file asks for them, since POSIX also
+ * defines a mode_t that clashes with the FSM's
+ */
+#define _GNU_SOURCE
+
+#include <linux/perf_event.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * User-defined libraries
+ */
+#include "host.h"
+#include "systick.h"
+
+/**
+ * \var		ticktime_t ticks_since_startup
+ * \brief	Moved on by the test driving the FSM, as the main loop does on the board
+ */
+ticktime_t ticks_since_startup = 0;
+
+uint32_t host_counts = 0;
+
+/**
+ * \var		int host_insn_fd
+ * \brief	Counter of user-mode instructions retired by this process. 0 until first used, -1 if
+ * 			the host does not allow it
+ */
+static int host_insn_fd = 0;
+
+uint32_t systick_counts(void)
+{
+	return (host_counts);
+}
+
+uint64_t host_nsec(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec);
+}
+
+uint64_t host_instructions(void)
+{
+	struct perf_event_attr attr;
+	uint64_t return_value = 0;
+
+	if(host_insn_fd == 0){
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		host_insn_fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+
+	if((host_insn_fd < 0) || (read(host_insn_fd, &return_value, sizeof(return_value)) != sizeof(return_value))){
+		return_value = 0;
+	}
+
+	return (return_value);
+}
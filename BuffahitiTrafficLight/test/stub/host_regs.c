@@ -0,0 +1,19 @@
+/**
+ * \file    host_regs.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   The peripherals and console declared by the host stand-in headers
+ */
+
+#include "board.h"
+#include "fsl_debug_console.h"
+
+TPM_Type host_tpm0;
+TPM_Type host_tpm2;
+PORT_Type host_portb;
+PORT_Type host_portd;
+GPIO_Type host_ptb;
+GPIO_Type host_ptd;
+SIM_Type host_sim;
+
+FILE *host_console;
@@ -0,0 +1,138 @@
+/**
+ * \file    host_systick.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Model of SysTick for the host tests. The counter counts down once per clock while
+ * 			enabled. On reaching 0 it pends the SysTick interrupt, and on the next clock it reloads
+ * 			from LOAD, or from a VAL written as 0 without pending anything. A pending interrupt is
+ * 			taken host_systick_delay accesses later, between two accesses of whatever code is
+ * 			running, unless interrupts are masked or it is already being handled
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "core_cm0plus.h"
+
+/**
+ * User-defined libraries
+ */
+#include "systick.h"
+
+uint32_t host_systick_step = 1;
+uint32_t host_systick_delay = 0;
+bool host_systick_masked = false;
+uint32_t host_systick_scale = 1;
+uint64_t host_systick_elapsed = 0;
+uint64_t host_systick_reached = 0;
+
+/**
+ * \var		SysTick_Type host_systick_regs
+ * \brief	What SysTick points at
+ */
+static SysTick_Type host_systick_regs;
+
+/**
+ * \var		SCB_Type host_scb_regs
+ * \brief	What SCB points at
+ */
+static SCB_Type host_scb_regs;
+
+/**
+ * \var		uint32_t host_systick_waited
+ * \brief	Accesses the pending interrupt has waited so far
+ */
+static uint32_t host_systick_waited;
+
+/**
+ * \var		bool host_systick_handling
+ * \brief	True while SysTick_Handler() runs, so its own accesses don't take it again
+ */
+static bool host_systick_handling;
+
+/**
+ * \fn		void host_systick_run
+ * \param	uint32_t clocks Clocks of the counter to run
+ * \return	N/A
+ * \brief   Run the counter on, a stretch at a time rather than clock by clock
+ */
+static void host_systick_run(uint32_t clocks)
+{
+	while(clocks > 0){
+		if(host_systick_regs.VAL == 0){
+			host_systick_regs.VAL = host_systick_regs.LOAD & SysTick_LOAD_RELOAD_Msk;
+			host_systick_elapsed += host_systick_scale;
+			clocks--;
+		}
+		else if(clocks >= host_systick_regs.VAL){
+			host_systick_elapsed += (uint64_t)host_systick_regs.VAL * host_systick_scale;
+			host_systick_reached = host_systick_elapsed;
+			clocks -= host_systick_regs.VAL;
+			host_systick_regs.VAL = 0;
+			host_systick_regs.CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+
+			if(host_systick_regs.CTRL & SysTick_CTRL_TICKINT_Msk){
+				host_scb_regs.ICSR |= SCB_ICSR_PENDSTSET_Msk;
+			}
+		}
+		else{
+			host_systick_elapsed += (uint64_t)clocks * host_systick_scale;
+			host_systick_regs.VAL -= clocks;
+			clocks = 0;
+		}
+	}
+}
+
+/**
+ * \fn		void host_systick_access
+ * \param	N/A
+ * \return	N/A
+ * \brief   What happens between the previous access and this one
+ */
+static void host_systick_access(void)
+{
+    /**
+     * ICSR is written rather than set, so a write of PENDSTCLR has already dropped PENDSTSET
+     */
+	host_scb_regs.ICSR &= ~SCB_ICSR_PENDSTCLR_Msk;
+
+	if((host_scb_regs.ICSR & SCB_ICSR_PENDSTSET_Msk) && !host_systick_masked && !host_systick_handling){
+		if(host_systick_waited >= host_systick_delay){
+			host_scb_regs.ICSR &= ~SCB_ICSR_PENDSTSET_Msk;
+			host_systick_waited = 0;
+
+		    /**
+		     * Exception entry alone takes longer than a clock of the counter, so a counter that
+		     * has just reached 0 has reloaded before the handler can write LOAD
+		     */
+			if((host_systick_regs.CTRL & SysTick_CTRL_ENABLE_Msk) && (host_systick_regs.VAL == 0)){
+				host_systick_run(1);
+			}
+
+			host_systick_handling = true;
+			SysTick_Handler();
+			host_systick_handling = false;
+		}
+		else{
+			host_systick_waited++;
+		}
+	}
+
+	if(host_systick_regs.CTRL & SysTick_CTRL_ENABLE_Msk){
+		host_systick_run(host_systick_step);
+	}
+}
+
+SysTick_Type *host_systick(void)
+{
+	host_systick_access();
+
+	return (&host_systick_regs);
+}
+
+SCB_Type *host_scb(void)
+{
+	host_systick_access();
+
+	return (&host_scb_regs);
+}
@@ -0,0 +1,40 @@
+/**
+ * \file    host_tsi.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Model of the TSI for the host tests. A scan is started by setting SWTS, as
+ * 			scan_touch_blocking() and start_touch_scan() do, and is finished by the next access to
+ * 			TSI0: host_electrode is asked what a scan of NSCN + 1 oscillations reads, and the count
+ * 			lands in DATA with EOSF set. Without an electrode every scan reads 0
+ */
+
+#include <stdint.h>
+
+#include "board.h"
+
+/**
+ * \var		TSI_Type host_tsi_regs
+ * \brief	What TSI0 points at
+ */
+static TSI_Type host_tsi_regs;
+
+host_electrode_t host_electrode;
+
+TSI_Type *host_tsi(void)
+{
+	uint32_t oscillations;
+
+	if(host_tsi_regs.DATA & TSI_DATA_SWTS_MASK){
+		oscillations = ((host_tsi_regs.GENCS & TSI_GENCS_NSCN_MASK) >> TSI_GENCS_NSCN_SHIFT) + 1;
+
+		host_tsi_regs.DATA &= ~(TSI_DATA_SWTS_MASK | TSI_DATA_TSICNT_MASK);
+
+		if(host_electrode != NULL){
+			host_tsi_regs.DATA |= host_electrode(oscillations) & TSI_DATA_TSICNT_MASK;
+		}
+
+		host_tsi_regs.GENCS |= TSI_GENCS_EOSF_MASK;
+	}
+
+	return (&host_tsi_regs);
+}
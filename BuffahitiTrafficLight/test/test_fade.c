@@ -0,0 +1,186 @@
+/**
+ * \file    test_fade.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host tests of the fixed-point fade taken by start_fade() and step_leds(), for fades of
+ * 			any length and between any two levels. Every fade has to end exactly on its targets,
+ * 			never turn back, and stay within 1 level of the straight line between its ends. Prints
+ * 			one line per fade length:
+ * 			fade,<steps>,<fades>,<off target>,<not monotonic>,<off line>
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * User-defined libraries
+ */
+#include "fsm_trafficlight.h"
+#include "led.h"
+#include "systick.h"
+
+/**
+ * \def		LONG_FADE_STEPS
+ * \brief	Fades longer than this only start and end on every LONG_FADE_STRIDE-th level, to keep
+ * 			the run short
+ */
+#define LONG_FADE_STEPS\
+	(64)
+
+/**
+ * \def		LONG_FADE_STRIDE
+ * \brief	See LONG_FADE_STEPS
+ */
+#define LONG_FADE_STRIDE\
+	(3)
+
+/**
+ * \var		const uint32_t fade_lengths[]
+ * \brief	Every length tested, in steps. Includes the tick fade, lengths that don't divide any
+ * 			level difference, and lengths past the 255 a uint8_t could count
+ */
+static const uint32_t fade_lengths[] = {
+	1, 2, 3, 5, 7, TICKS_PER_TRANSITION - 1, TICKS_PER_TRANSITION, 17, 100, 255, 256, 257, 1000, 4095
+};
+
+/**
+ * \typedef	fade_check_t
+ * \brief	To allow objects of struct fade_check_s to be declared with ease
+ */
+typedef struct fade_check_s fade_check_t;
+
+/**
+ * \struct	fade_check_s
+ * \brief	Failures found over every fade of one length
+ */
+struct fade_check_s {
+	uint32_t off_target;
+	uint32_t not_monotonic;
+	uint32_t off_line;
+};
+
+/**
+ * \fn		void check_step
+ * \param	uint8_t start Level the channel faded from
+ * \param	uint8_t end Level the channel is fading to
+ * \param	uint8_t previous Level before this step
+ * \param	uint8_t level Level after this step
+ * \param	uint32_t step Steps taken, including this one
+ * \param	uint32_t steps Steps in the fade
+ * \param	fade_check_t *check Receives any failure
+ * \return	N/A
+ * \brief   Check one channel after one step
+ */
+static void check_step(uint8_t start, uint8_t end, uint8_t previous, uint8_t level, uint32_t step, uint32_t steps, fade_check_t *check)
+{
+	int64_t line = (int64_t)start * steps + ((int64_t)end - start) * step;
+	int64_t distance = (int64_t)level * steps - line;
+
+	if(((end >= start) && (level < previous)) || ((end < start) && (level > previous))){
+		check->not_monotonic++;
+	}
+
+    /**
+     * Compared in units of 1 / steps of a level, so there is no rounding in the check itself
+     */
+	if((distance > (int64_t)steps) || (distance < -(int64_t)steps)){
+		check->off_line++;
+	}
+
+	if((step == steps) && (level != end)){
+		check->off_target++;
+	}
+}
+
+/**
+ * \fn		void check_fade
+ * \param	uint8_t from Level the red channel fades from, and green and blue fade to
+ * \param	uint8_t to Level the red channel fades to, and green and blue fade from
+ * \param	uint32_t steps Steps in the fade
+ * \param	fade_check_t *check Receives any failure
+ * \return	N/A
+ * \brief   Run one fade through start_fade() and step_leds(). Green fades the other way to red,
+ * 			and blue from a different level, so the three channels never step alike
+ */
+static void check_fade(uint8_t from, uint8_t to, uint32_t steps, fade_check_t *check)
+{
+	trafficlight_t tl = {0};
+	state_t previous;
+	uint8_t blue_from = from ^ 0x5A;
+	uint32_t step;
+
+	tl.current.red_level = from;
+	tl.current.green_level = to;
+	tl.current.blue_level = blue_from;
+	tl.red_level_end = to;
+	tl.green_level_end = from;
+	tl.blue_level_end = to;
+
+	start_fade(&tl, steps);
+
+	for(step = 1; step <= steps; step++){
+		previous = tl.current;
+		step_leds(&tl);
+
+		check_step(from, to, previous.red_level, tl.current.red_level, step, steps, check);
+		check_step(to, from, previous.green_level, tl.current.green_level, step, steps, check);
+		check_step(blue_from, to, previous.blue_level, tl.current.blue_level, step, steps, check);
+	}
+
+    /**
+     * Stepping past the end leaves the targets alone
+     */
+	step_leds(&tl);
+
+	if((tl.current.red_level != to) || (tl.current.green_level != from) || (tl.current.blue_level != to)){
+		check->off_target++;
+	}
+}
+
+/**
+ * \fn		uint32_t test_length
+ * \param	uint32_t steps Steps in each fade
+ * \return	Number of failures
+ * \brief   Fade between every pair of levels, or every LONG_FADE_STRIDE-th for long fades
+ */
+static uint32_t test_length(uint32_t steps)
+{
+	fade_check_t check = {0};
+	uint32_t stride = (steps > LONG_FADE_STEPS) ? LONG_FADE_STRIDE : 1;
+	uint32_t fades = 0;
+	uint32_t from;
+	uint32_t to;
+
+	for(from = 0; from < NUM_LED_LEVELS; from += stride){
+		for(to = 0; to < NUM_LED_LEVELS; to += stride){
+			check_fade((uint8_t)from, (uint8_t)to, steps, &check);
+			fades++;
+		}
+	}
+
+	printf("fade,%u,%u,%u,%u,%u\n", steps, fades, check.off_target, check.not_monotonic, check.off_line);
+
+	return (check.off_target + check.not_monotonic + check.off_line);
+}
+
+int main(void)
+{
+	trafficlight_t tl = {0};
+	uint32_t failures = 0;
+	uint32_t n;
+
+	for(n = 0; n < sizeof(fade_lengths) / sizeof(fade_lengths[0]); n++){
+		failures += test_length(fade_lengths[n]);
+	}
+
+    /**
+     * A fade of no steps jumps straight to the targets
+     */
+	tl.current.red_level = 10;
+	tl.red_level_end = 200;
+	start_fade(&tl, 0);
+	failures += (tl.current.red_level != 200);
+
+	return (failures != 0);
+}
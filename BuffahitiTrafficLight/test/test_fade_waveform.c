@@ -0,0 +1,141 @@
+/**
+ * \file    test_fade_waveform.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host tests of the waveform LED_FADE_DMA copies into the TPM. Built in LED_FADE_PWM mode,
+ * 			so the software fade is there to compare against: for every fade, what
+ * 			fill_fade_waveform() writes has to be exactly the CnV values TPM2_IRQHandler() writes
+ * 			period by period, no more and no fewer. Prints one line:
+ * 			fade_waveform,<fades>,<periods>,<mismatched periods>,<wrong lengths>
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * User-defined libraries
+ */
+#include "board.h"
+#include "fsm_trafficlight.h"
+#include "led.h"
+#include "systick.h"
+#include "tpm.h"
+
+/**
+ * \def		WAVEFORM_GUARD
+ * \brief	Entries past the end of the waveform that must be left alone
+ */
+#define WAVEFORM_GUARD\
+	(4)
+
+/**
+ * \def		GUARD_COUNTS
+ * \brief	Written to every entry before filling, and never a valid count
+ */
+#define GUARD_COUNTS\
+	(0xFFFF)
+
+/**
+ * \var		uint16_t waveform[NUM_LED_COLOURS][FADE_PWM_STEPS + WAVEFORM_GUARD]
+ * \brief	What fill_fade_waveform() writes, one row per colour
+ */
+static uint16_t waveform[NUM_LED_COLOURS][FADE_PWM_STEPS + WAVEFORM_GUARD];
+
+/**
+ * \var		uint32_t mismatches, wrong_lengths, periods
+ * \brief	Totals over every fade
+ */
+static uint32_t mismatches;
+static uint32_t wrong_lengths;
+static uint32_t periods;
+
+/**
+ * \fn		void check_fade
+ * \param	const state_t *from Levels shown before the fade
+ * \param	const state_t *to Levels the fade heads for
+ * \return	N/A
+ * \brief   Fill the waveform for one fade, then run the same fade through the TPM2 overflow
+ * 			interrupt and compare. The fade starts from the levels set_onboard_leds() leaves, and
+ * 			its steps are worked out as fade_onboard_leds() does
+ */
+static void check_fade(const state_t *from, const state_t *to)
+{
+	trafficlight_t tl = {0};
+	fade_t start = {0};
+	uint32_t period;
+	uint32_t n;
+
+	start.red_level = from->red_level * FADE_ONE;
+	start.green_level = from->green_level * FADE_ONE;
+	start.blue_level = from->blue_level * FADE_ONE;
+	start.red_step = (to->red_level * FADE_ONE - start.red_level) / FADE_PWM_STEPS;
+	start.green_step = (to->green_level * FADE_ONE - start.green_level) / FADE_PWM_STEPS;
+	start.blue_step = (to->blue_level * FADE_ONE - start.blue_level) / FADE_PWM_STEPS;
+	start.steps_left = FADE_PWM_STEPS;
+
+	for(n = 0; n < FADE_PWM_STEPS + WAVEFORM_GUARD; n++){
+		waveform[RED_LED][n] = GUARD_COUNTS;
+		waveform[GREEN_LED][n] = GUARD_COUNTS;
+		waveform[BLUE_LED][n] = GUARD_COUNTS;
+	}
+
+	fill_fade_waveform(&start, to, waveform[RED_LED], waveform[GREEN_LED], waveform[BLUE_LED]);
+
+    /**
+     * The software fade, one overflow at a time until it turns its interrupt off
+     */
+	tl.current = *from;
+	set_onboard_leds(&tl);
+
+	tl.current = *to;
+	tl.transitioning = true;
+	fade_onboard_leds(&tl);
+
+	for(period = 0; onboard_leds_fading() && (period < FADE_PWM_STEPS + WAVEFORM_GUARD); period++){
+		TPM2_IRQHandler();
+
+		if((TPM2->CONTROLS[RED_LED_TPM2_CHANNEL].CnV != waveform[RED_LED][period]) ||
+			(TPM2->CONTROLS[GREEN_LED_TPM2_CHANNEL].CnV != waveform[GREEN_LED][period]) ||
+			(TPM0->CONTROLS[BLUE_LED_TPM0_CHANNEL].CnV != waveform[BLUE_LED][period])){
+			mismatches++;
+		}
+	}
+
+	periods += period;
+
+	if((period != FADE_PWM_STEPS) || (waveform[RED_LED][FADE_PWM_STEPS] != GUARD_COUNTS)){
+		wrong_lengths++;
+	}
+}
+
+int main(void)
+{
+	state_t from = {0};
+	state_t to = {0};
+	uint32_t fades = 0;
+	uint32_t a;
+	uint32_t b;
+
+    /**
+     * Red between every pair of levels. Green fades the other way and blue from a different
+     * level, so the three channels never step alike
+     */
+	for(a = 0; a < NUM_LED_LEVELS; a++){
+		for(b = 0; b < NUM_LED_LEVELS; b++){
+			from.red_level = (uint8_t)a;
+			from.green_level = (uint8_t)b;
+			from.blue_level = (uint8_t)(a ^ 0x5A);
+			to.red_level = (uint8_t)b;
+			to.green_level = (uint8_t)a;
+			to.blue_level = (uint8_t)b;
+
+			check_fade(&from, &to);
+			fades++;
+		}
+	}
+
+	printf("fade_waveform,%u,%u,%u,%u\n", fades, periods, mismatches, wrong_lengths);
+
+	return ((mismatches + wrong_lengths) != 0);
+}
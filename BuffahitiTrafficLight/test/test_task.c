@@ -0,0 +1,351 @@
+/**
+ * \file    test_task.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host tests of the run-to-completion task scheduler in task.c, on the virtual clock.
+ * 			Ready tasks have to run highest priority first, triggers of a ready task have to
+ * 			coalesce, a task triggered while it runs has to run again, a slot never initialized
+ * 			never runs, a periodic task runs once however many of its periods were missed and keeps
+ * 			its phase, and task_report() has to print the run and wait times it was given. Prints
+ * 			one line per check:
+ * 			task,<check>,<runs>,<wrong>
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fsl_debug_console.h"
+#include "host.h"
+
+/**
+ * User-defined libraries
+ */
+#include "systick.h"
+#include "task.h"
+
+/**
+ * \def		RUN_LOG_LENGTH
+ * \brief	Most task runs a check can log
+ */
+#define RUN_LOG_LENGTH\
+	(64)
+
+/**
+ * \def		PERIODIC_TICKS
+ * \brief	Length of the periodic check, in ticks
+ */
+#define PERIODIC_TICKS\
+	(100000)
+
+/**
+ * \def		PERIOD_TICKS
+ * \brief	Period of the task in the periodic check
+ */
+#define PERIOD_TICKS\
+	(5)
+
+/**
+ * \def		RUN_COUNTS, WAIT_COUNTS
+ * \brief	SysTick counts each run of a task takes, and the most a task waits, in the report check.
+ * 			Whole usec, so the report prints them exactly
+ */
+#define RUN_COUNTS\
+	(30 * COUNTS_PER_USEC)
+#define WAIT_COUNTS\
+	(500 * COUNTS_PER_USEC)
+
+/**
+ * \var		task_id_t run_log[RUN_LOG_LENGTH]
+ * \brief	Every task run since the log was last cleared, in order
+ */
+static task_id_t run_log[RUN_LOG_LENGTH];
+
+/**
+ * \var		uint32_t run_count
+ * \brief	Entries in run_log, which may be more than it holds
+ */
+static uint32_t run_count;
+
+/**
+ * \var		uint32_t self_triggers
+ * \brief	How many more times logged_task() triggers its own task while it runs
+ */
+static uint32_t self_triggers;
+
+/**
+ * \var		uint32_t seed
+ * \brief	State of the pseudo-random generator
+ */
+static uint32_t seed = 2463534242UL;
+
+/**
+ * \fn		uint32_t next_random
+ * \param	N/A
+ * \return	The next pseudo-random value
+ * \brief   xorshift32, so every run is reproducible
+ */
+static uint32_t next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return (seed);
+}
+
+/**
+ * \fn		void logged_task
+ * \param	void *arg The task's own task_id_t
+ * \return	N/A
+ * \brief   The body of every task: log the run, take RUN_COUNTS, and trigger itself again while
+ * 			self_triggers lasts
+ */
+static void logged_task(void *arg)
+{
+	task_id_t id = *(const task_id_t *)arg;
+
+	if(run_count < RUN_LOG_LENGTH){
+		run_log[run_count] = id;
+	}
+
+	run_count++;
+	host_counts += RUN_COUNTS;
+
+	if(self_triggers > 0){
+		self_triggers--;
+		task_trigger(id);
+	}
+}
+
+/**
+ * \var		const task_id_t task_ids[NUM_TASKS]
+ * \brief	What each task is given as its arg
+ */
+static const task_id_t task_ids[NUM_TASKS] = {
+	TASK_FSM, TASK_TOUCH, TASK_SCAN, TASK_TRACE, TASK_PROFILE, TASK_CONSOLE
+};
+
+/**
+ * \fn		void reset_tasks
+ * \param	uint32_t period_ticks Period given to TASK_TRACE, 0 for none
+ * \return	N/A
+ * \brief   Initialize every slot but TASK_PROFILE, which is left empty, and clear the log and the
+ * 			report totals
+ */
+static void reset_tasks(uint32_t period_ticks)
+{
+	FILE *saved = host_console;
+	task_id_t id;
+
+	for(id = 0; id < NUM_TASKS; id++){
+		if(id != TASK_PROFILE){
+			init_task(id, logged_task, (void *)&task_ids[id], (id == TASK_TRACE) ? period_ticks : 0, 0);
+		}
+	}
+
+	host_console = fopen("/dev/null", "w");
+	task_report();
+	fclose(host_console);
+	host_console = saved;
+
+	run_count = 0;
+	self_triggers = 0;
+}
+
+/**
+ * \fn		uint32_t run_all
+ * \param	N/A
+ * \return	Number of tasks run
+ * \brief   Run tasks until none is ready, as the main loop does
+ */
+static uint32_t run_all(void)
+{
+	uint32_t runs = 0;
+
+	while(task_run_next()){
+		runs++;
+	}
+
+	return (runs);
+}
+
+/**
+ * \fn		uint32_t report_check
+ * \param	const char *check Name printed for the check
+ * \param	uint32_t runs Tasks the check ran
+ * \param	uint32_t wrong What the check found wrong
+ * \return	wrong
+ * \brief   Print one check's line
+ */
+static uint32_t report_check(const char *check, uint32_t runs, uint32_t wrong)
+{
+	printf("task,%s,%u,%u\n", check, runs, wrong);
+
+	return (wrong);
+}
+
+/**
+ * \fn		uint32_t test_priority
+ * \param	N/A
+ * \return	Number of failures
+ * \brief   Trigger every task lowest priority first. They have to run highest priority first,
+ * 			each once, and the empty TASK_PROFILE slot never
+ */
+static uint32_t test_priority(void)
+{
+	uint32_t wrong = 0;
+	uint32_t runs;
+	uint32_t n;
+	int32_t id;
+
+	reset_tasks(0);
+
+	for(id = NUM_TASKS - 1; id >= 0; id--){
+		task_trigger((task_id_t)id);
+	}
+
+	runs = run_all();
+
+	for(id = 0, n = 0; id < NUM_TASKS; id++){
+		if(id == TASK_PROFILE){
+			continue;
+		}
+
+		wrong += (n >= run_count) || (run_log[n] != (task_id_t)id);
+		n++;
+	}
+
+	wrong += (run_count != n);
+
+	return (report_check("priority", runs, wrong));
+}
+
+/**
+ * \fn		uint32_t test_coalesce
+ * \param	N/A
+ * \return	Number of failures
+ * \brief   Triggers of a task that is already ready run it once. A task that triggers itself while
+ * 			it runs, which clears ready first, runs once more for each time
+ */
+static uint32_t test_coalesce(void)
+{
+	uint32_t wrong = 0;
+	uint32_t runs;
+	uint32_t n;
+
+	reset_tasks(0);
+
+	task_trigger(TASK_TOUCH);
+	task_trigger(TASK_TOUCH);
+	task_trigger(TASK_TOUCH);
+	runs = run_all();
+
+	wrong += (run_count != 1);
+
+	run_count = 0;
+	self_triggers = 3;
+	task_trigger(TASK_SCAN);
+	task_trigger(TASK_SCAN);
+	runs += run_all();
+
+	wrong += (run_count != 4);
+
+	for(n = 0; n < run_count && n < RUN_LOG_LENGTH; n++){
+		wrong += (run_log[n] != TASK_SCAN);
+	}
+
+	return (report_check("coalesce", runs, wrong));
+}
+
+/**
+ * \fn		uint32_t test_periodic
+ * \param	N/A
+ * \return	Number of failures
+ * \brief   Advance to random ticks, sometimes many periods apart. TASK_TRACE has to be ready exactly
+ * 			when a multiple of PERIOD_TICKS was reached since the last advance, and run once for all
+ * 			of them
+ */
+static uint32_t test_periodic(void)
+{
+	uint32_t wrong = 0;
+	uint32_t runs = 0;
+	uint32_t previous = 0;
+	uint32_t now = 0;
+	bool due;
+
+	reset_tasks(PERIOD_TICKS);
+
+	while(now < PERIODIC_TICKS){
+		now += (next_random() % 8 == 0) ? (1 + next_random() % (4 * PERIOD_TICKS)) : 1;
+
+		due = (now / PERIOD_TICKS) != (previous / PERIOD_TICKS);
+		previous = now;
+
+		run_count = 0;
+		task_advance(now);
+		runs += run_all();
+
+		wrong += (run_count != (due ? 1 : 0));
+	}
+
+	return (report_check("periodic", runs, wrong));
+}
+
+/**
+ * \fn		uint32_t test_report
+ * \param	N/A
+ * \return	Number of failures
+ * \brief   Run TASK_FSM after waits of up to WAIT_COUNTS. task_report() has to print its runs, their
+ * 			RUN_COUNTS each and the longest wait, all in usec, and nothing for tasks that did not
+ * 			run
+ */
+static uint32_t test_report(void)
+{
+	FILE *saved = host_console;
+	char printed[256];
+	char expected[256];
+	uint32_t wrong = 0;
+	uint32_t runs = 0;
+	uint32_t n;
+	size_t length;
+
+	reset_tasks(0);
+
+	for(n = 0; n < 10; n++){
+		task_trigger(TASK_FSM);
+		host_counts += (n == 6) ? WAIT_COUNTS : (next_random() % WAIT_COUNTS);
+		runs += run_all();
+	}
+
+	host_console = tmpfile();
+	task_report();
+	rewind(host_console);
+	length = fread(printed, 1, sizeof(printed) - 1, host_console);
+	printed[length] = '\0';
+	fclose(host_console);
+	host_console = saved;
+
+	snprintf(expected, sizeof(expected), "task,fsm,%u,%u,%u,%u\r\n",
+		runs,
+		RUN_COUNTS / COUNTS_PER_USEC,
+		RUN_COUNTS / COUNTS_PER_USEC,
+		WAIT_COUNTS / COUNTS_PER_USEC);
+
+	wrong += (strcmp(printed, expected) != 0);
+
+	return (report_check("report", runs, wrong));
+}
+
+int main(void)
+{
+	uint32_t failures = 0;
+
+	failures += test_priority();
+	failures += test_coalesce();
+	failures += test_periodic();
+	failures += test_report();
+
+	return (failures != 0);
+}
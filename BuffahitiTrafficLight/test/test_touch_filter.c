@@ -0,0 +1,325 @@
+/**
+ * \file    test_touch_filter.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host tests of the touch detection pipeline over synthetic scan traces. Each trace is
+ * 			fed to filter_touch() on its own, then through the FSM, where the touchpad keeps being
+ * 			sampled across the CROSSWALK phase. Prints one line per trace:
+ * 			touch_filter,<trace>,<samples>,<presses>,<touches>,<false touches>,<missed presses>
+ * 			touch_fsm,<trace>,<ticks>,<presses>,<crosswalks>,<phantom crosswalks>,<missed presses>
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * User-defined libraries
+ */
+#include "fsm_trafficlight.h"
+#include "swtimer.h"
+#include "systick.h"
+#include "touch.h"
+#include "touch_filter.h"
+
+/**
+ * \def		TRACE_SAMPLES
+ * \brief	Length of every trace, one sample per tick
+ */
+#define TRACE_SAMPLES\
+	(200000)
+
+/**
+ * \def		TRACE_BASELINE
+ * \brief	Raw reading of the untouched electrode at the start of every trace
+ */
+#define TRACE_BASELINE\
+	(1000)
+
+/**
+ * \def		PRESS_SAMPLES
+ * \brief	Samples each press lasts, a quick tap at TICK_HZ
+ */
+#define PRESS_SAMPLES\
+	(6)
+
+/**
+ * \def		PRESS_REACH
+ * \brief	A touch is only blamed on a press that started at most this many samples earlier, or
+ * 			that is still being released
+ */
+#define PRESS_REACH\
+	(PRESS_SAMPLES + TOUCH_DEBOUNCE_SAMPLES + 2)
+
+/**
+ * \typedef	trace_desc_t
+ * \brief	To allow objects of struct trace_desc_s to be declared with ease
+ */
+typedef struct trace_desc_s trace_desc_t;
+
+/**
+ * \struct	trace_desc_s
+ * \brief	How one trace is generated. Noise is uniform in +-noise, a spike is a single sample
+ * 			spike counts high every spike_every samples, drift is in 1/1000 counts per sample, and
+ * 			presses of press counts are spaced press_gap samples apart or more
+ */
+struct trace_desc_s {
+	const char *name;
+	uint32_t noise;
+	uint32_t spike;
+	uint32_t spike_every;
+	int32_t drift;
+	uint32_t press;
+	uint32_t press_gap;
+};
+
+/**
+ * \var		const trace_desc_t trace_descs[]
+ * \brief	Every trace tested. Noise stays within what calibration would accept, MIN_TOUCH at least
+ * 			TOUCH_NOISE_MARGIN times the mean noise
+ */
+static const trace_desc_t trace_descs[] = {
+	{ .name = "quiet", .noise = 2 },
+	{ .name = "noisy", .noise = 40 },
+	{ .name = "spikes", .noise = 10, .spike = 3 * MIN_TOUCH, .spike_every = 37 },
+	{ .name = "drift_up", .noise = 10, .drift = 50 },
+	{ .name = "drift_down", .noise = 10, .drift = -4 },
+	{ .name = "quiet_presses", .noise = 2, .press = 3 * MIN_TOUCH, .press_gap = 20 },
+	{ .name = "noisy_presses", .noise = 40, .press = 3 * MIN_TOUCH, .press_gap = 20 },
+	{ .name = "weak_presses", .noise = 10, .press = (3 * MIN_TOUCH) / 2, .press_gap = 20 },
+	{ .name = "drift_presses", .noise = 10, .drift = 50, .press = 3 * MIN_TOUCH, .press_gap = 20 }
+};
+
+/**
+ * \var		uint32_t trace[TRACE_SAMPLES]
+ * \brief	Raw samples of the trace under test
+ */
+static uint32_t trace[TRACE_SAMPLES];
+
+/**
+ * \var		uint32_t press_start[TRACE_SAMPLES]
+ * \brief	For each sample, where the latest press at or before it started, or TRACE_SAMPLES if
+ * 			none has
+ */
+static uint32_t press_start[TRACE_SAMPLES];
+
+/**
+ * \var		uint32_t presses
+ * \brief	Number of presses in the trace under test
+ */
+static uint32_t presses;
+
+/**
+ * \fn		uint32_t next_random
+ * \param	uint32_t *seed The generator's state
+ * \return	The next pseudo-random value
+ * \brief   xorshift32, so every trace is reproducible
+ */
+static uint32_t next_random(uint32_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+
+	return (*seed);
+}
+
+/**
+ * \fn		void make_trace
+ * \param	const trace_desc_t *desc The trace
+ * \return	N/A
+ * \brief   Fill trace, press_start and presses
+ */
+static void make_trace(const trace_desc_t *desc)
+{
+	uint32_t seed = 2463534242UL;
+	uint32_t next_press = desc->press_gap;
+	uint32_t start = TRACE_SAMPLES;
+	int64_t drift = 0;
+	uint32_t n;
+	int32_t raw;
+
+	presses = 0;
+
+	for(n = 0; n < TRACE_SAMPLES; n++){
+		drift += desc->drift;
+		raw = TRACE_BASELINE + (int32_t)(drift / 1000);
+		raw += (int32_t)(next_random(&seed) % (2 * desc->noise + 1)) - (int32_t)desc->noise;
+
+		if((desc->spike_every != 0) && ((n % desc->spike_every) == 0)){
+			raw += desc->spike;
+		}
+
+	    /**
+	     * Presses start a random gap after the previous one ends, so they land on every phase of
+	     * the FSM
+	     */
+		if((desc->press != 0) && (n == next_press)){
+			start = n;
+			presses++;
+			next_press = n + PRESS_SAMPLES + desc->press_gap + (next_random(&seed) % (SEC_TO_TICKS(30)));
+		}
+
+		if((start != TRACE_SAMPLES) && (n - start < PRESS_SAMPLES)){
+			raw += desc->press;
+		}
+
+		trace[n] = (raw < 0) ? 0 : (uint32_t)raw;
+		press_start[n] = start;
+	}
+}
+
+/**
+ * \fn		bool near_press
+ * \param	uint32_t n A sample
+ * \return	Returns true if a press started at most PRESS_REACH samples before n
+ * \brief   Whether a touch reported at n can be blamed on a press
+ */
+static bool near_press(uint32_t n)
+{
+	return ((press_start[n] != TRACE_SAMPLES) && (n - press_start[n] <= PRESS_REACH));
+}
+
+/**
+ * \fn		uint32_t test_filter
+ * \param	const trace_desc_t *desc The trace, already made
+ * \return	Number of failures
+ * \brief   Feed the trace to filter_touch() on its own. Every press has to be reported once, and
+ * 			nothing else ever
+ */
+static uint32_t test_filter(const trace_desc_t *desc)
+{
+	touch_filter_t filter;
+	uint32_t touches = 0;
+	uint32_t false_touches = 0;
+	uint32_t missed = 0;
+	uint32_t reported_press = TRACE_SAMPLES;
+	bool touched = false;
+	bool was_touched;
+	uint32_t n;
+
+	init_touch_filter(&filter, TRACE_BASELINE, desc->noise / 2);
+
+	for(n = 0; n < TRACE_SAMPLES; n++){
+		was_touched = touched;
+		touched = touch_detect(filter_touch(&filter, trace[n]));
+
+		if(touched && !was_touched){
+			touches++;
+
+			if(!near_press(n) || (press_start[n] == reported_press)){
+				false_touches++;
+			}
+
+			reported_press = press_start[n];
+		}
+
+	    /**
+	     * A press is missed if it is over and nothing was reported for it
+	     */
+		if((press_start[n] != TRACE_SAMPLES) && (n - press_start[n] == PRESS_REACH) && (reported_press != press_start[n])){
+			missed++;
+		}
+	}
+
+	printf("touch_filter,%s,%u,%u,%u,%u,%u\n", desc->name, TRACE_SAMPLES, presses, touches, false_touches, missed);
+
+	return (false_touches + missed);
+}
+
+/**
+ * \fn		bool trace_input_sample
+ * \param	void *context The touch_filter_t the trace goes through
+ * \return	Returns true if this tick's sample of the trace reads as a touch
+ * \brief   touch_input_t of the light under test. Sample n is scanned on tick n + 1 whether the
+ * 			light samples it or not, like the touchpad
+ */
+static bool trace_input_sample(void *context)
+{
+	return (touch_detect(filter_touch(context, trace[ticks_since_startup - 1])));
+}
+
+/**
+ * \fn		void output_nothing
+ * \param	const trafficlight_t *tl Unused
+ * \param	bool lit Unused
+ * \return	N/A
+ * \brief   led_output_t of the light under test
+ */
+static void output_nothing(const trafficlight_t *tl, bool lit)
+{
+}
+
+/**
+ * \fn		uint32_t test_fsm
+ * \param	const trace_desc_t *desc The trace, already made
+ * \return	Number of failures
+ * \brief   Feed the trace to a traffic light, one sample per tick. CROSSWALK may only start on a
+ * 			press, in particular not on the first samples after it ends, and every press that
+ * 			starts while the light is outside CROSSWALK has to start one
+ */
+static uint32_t test_fsm(const trace_desc_t *desc)
+{
+	trafficlight_t tl;
+	swtimer_wheel_t timers;
+	touch_filter_t filter;
+	uint32_t crosswalks = 0;
+	uint32_t phantoms = 0;
+	uint32_t missed = 0;
+	uint32_t owed_press = TRACE_SAMPLES;
+	uint32_t n;
+	mode_t mode;
+
+	ticks_since_startup = 0;
+	init_touch_filter(&filter, TRACE_BASELINE, desc->noise / 2);
+
+	init_swtimer_wheel(&timers, ticks_since_startup);
+	init_fsm_trafficlight(&tl, &timers, trace_input_sample, &filter, output_nothing);
+
+	for(n = 0; n < TRACE_SAMPLES; n++){
+		mode = tl.current.mode;
+
+	    /**
+	     * A press that starts outside CROSSWALK is owed a CROSSWALK
+	     */
+		if((press_start[n] == n) && (mode != CROSSWALK)){
+			owed_press = n;
+		}
+
+		ticks_since_startup++;
+		update_fsm(&tl);
+
+		if((mode != CROSSWALK) && (tl.current.mode == CROSSWALK)){
+			crosswalks++;
+
+			if(!near_press(n)){
+				phantoms++;
+			}
+
+			owed_press = TRACE_SAMPLES;
+		}
+
+		if((owed_press != TRACE_SAMPLES) && (n - owed_press == PRESS_REACH)){
+			missed++;
+			owed_press = TRACE_SAMPLES;
+		}
+	}
+
+	printf("touch_fsm,%s,%u,%u,%u,%u,%u\n", desc->name, TRACE_SAMPLES, presses, crosswalks, phantoms, missed);
+
+	return (phantoms + missed);
+}
+
+int main(void)
+{
+	uint32_t failures = 0;
+	uint32_t n;
+
+	for(n = 0; n < sizeof(trace_descs) / sizeof(trace_descs[0]); n++){
+		make_trace(&trace_descs[n]);
+		failures += test_filter(&trace_descs[n]);
+		failures += test_fsm(&trace_descs[n]);
+	}
+
+	return (failures != 0);
+}
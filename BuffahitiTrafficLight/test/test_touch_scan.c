@@ -0,0 +1,294 @@
+/**
+ * \file    test_touch_scan.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host tests of the adaptive TSI scan length, running touch.c against the TSI model in
+ * 			host_tsi.c. Each electrode is calibrated by init_onboard_touch_sensor() and then scanned
+ * 			once per tick, as in TOUCH_MODE_POLL. A quieter electrode has to get a scan at least as
+ * 			short as a noisier one, scans have to lengthen when the noise rises, and every press has
+ * 			to be reported once with nothing else ever. Prints one line per electrode:
+ * 			touch_scan,<electrode>,<calibrated shift>,<final shift>,<oscillations per scan>,<presses>,<touches>,<false touches>,<missed presses>
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * User-defined libraries
+ */
+#include "board.h"
+#include "touch.h"
+#include "touch_filter.h"
+
+/**
+ * \def		SCAN_SAMPLES
+ * \brief	Scans taken of every electrode after calibration
+ */
+#define SCAN_SAMPLES\
+	(100000)
+
+/**
+ * \def		ELECTRODE_BASELINE
+ * \brief	What a full-length scan of the untouched electrode reads
+ */
+#define ELECTRODE_BASELINE\
+	(1000)
+
+/**
+ * \def		PRESS_SAMPLES
+ * \brief	Samples each press lasts, a quick tap at TICK_HZ
+ */
+#define PRESS_SAMPLES\
+	(6)
+
+/**
+ * \def		PRESS_GAP
+ * \brief	Presses are at least this many samples apart
+ */
+#define PRESS_GAP\
+	(40)
+
+/**
+ * \def		PRESS_REACH
+ * \brief	A touch is only blamed on a press that started at most this many samples earlier. Allows
+ * 			for the settling after a change of scan length as well as the debounce
+ */
+#define PRESS_REACH\
+	(PRESS_SAMPLES + TOUCH_SETTLE_SAMPLES + TOUCH_DEBOUNCE_SAMPLES + 2)
+
+/**
+ * \def		RISE_SAMPLES_PER_COUNT
+ * \brief	Rising noise grows by a full-length count every this many samples. The noise estimate
+ * 			follows a ramp, but a sudden step many times over can still read as a touch before the
+ * 			scan is lengthened
+ */
+#define RISE_SAMPLES_PER_COUNT\
+	(20)
+
+/**
+ * \typedef	electrode_desc_t
+ * \brief	To allow objects of struct electrode_desc_s to be declared with ease
+ */
+typedef struct electrode_desc_s electrode_desc_t;
+
+/**
+ * \struct	electrode_desc_s
+ * \brief	How one electrode behaves. Noise is uniform in +-noise full-length counts on a
+ * 			full-length scan, and grows as the square root of how much shorter a scan is. From
+ * 			sample rise_at on, it ramps up to rise_noise. 0 rise_at for none
+ */
+struct electrode_desc_s {
+	const char *name;
+	uint32_t noise;
+	uint32_t rise_at;
+	uint32_t rise_noise;
+};
+
+/**
+ * \var		const electrode_desc_t electrode_descs[]
+ * \brief	Every electrode tested, the steady ones from quietest to noisiest
+ */
+static const electrode_desc_t electrode_descs[] = {
+	{ .name = "quiet", .noise = 2 },
+	{ .name = "typical", .noise = 8 },
+	{ .name = "noisy", .noise = 20 },
+	{ .name = "very_noisy", .noise = 30 },
+	{ .name = "noise_rise", .noise = 2, .rise_at = SCAN_SAMPLES / 2, .rise_noise = 25 }
+};
+
+/**
+ * \var		uint32_t seed
+ * \brief	State of the noise generator
+ */
+static uint32_t seed;
+
+/**
+ * \var		uint32_t electrode_noise, electrode_press
+ * \brief	Noise and press of the electrode right now, in full-length counts
+ */
+static uint32_t electrode_noise;
+static uint32_t electrode_press;
+
+/**
+ * \var		uint64_t oscillations_scanned
+ * \brief	Electrode oscillations of every scan since it was last reset
+ */
+static uint64_t oscillations_scanned;
+
+/**
+ * \fn		uint32_t next_random
+ * \param	N/A
+ * \return	The next pseudo-random value
+ * \brief   xorshift32, so every run is reproducible
+ */
+static uint32_t next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return (seed);
+}
+
+/**
+ * \fn		uint32_t electrode_scan
+ * \param	uint32_t oscillations Length of the scan
+ * \return	What it reads
+ * \brief   host_electrode_t of the electrode under test
+ */
+static uint32_t electrode_scan(uint32_t oscillations)
+{
+	double full = (double)(GENCS_NSCN + 1);
+	double amplitude = electrode_noise * sqrt(full / oscillations);
+	double noise = ((next_random() % 2001) / 1000.0 - 1.0) * amplitude;
+	double value = ELECTRODE_BASELINE + electrode_press + noise;
+
+	oscillations_scanned += oscillations;
+
+	return ((uint32_t)((value * oscillations) / full + 0.5));
+}
+
+/**
+ * \fn		uint8_t scan_shift
+ * \param	N/A
+ * \return	How far scans are currently shortened, read back from NSCN
+ * \brief   The scan length touch.c has picked
+ */
+static uint8_t scan_shift(void)
+{
+	uint32_t nscn = (TSI0->GENCS & TSI_GENCS_NSCN_MASK) >> TSI_GENCS_NSCN_SHIFT;
+	uint8_t shift = 0;
+
+	while(((GENCS_NSCN + 1) >> shift) > nscn + 1){
+		shift++;
+	}
+
+	return (shift);
+}
+
+/**
+ * \fn		uint32_t test_electrode
+ * \param	const electrode_desc_t *desc The electrode
+ * \param	uint8_t *calibrated Receives the shift calibration picked
+ * \return	Number of failures
+ * \brief   Calibrate, then scan SCAN_SAMPLES times with a press every so often
+ */
+static uint32_t test_electrode(const electrode_desc_t *desc, uint8_t *calibrated)
+{
+	uint32_t presses = 0;
+	uint32_t touches = 0;
+	uint32_t false_touches = 0;
+	uint32_t missed = 0;
+	uint32_t press_start = SCAN_SAMPLES;
+	uint32_t next_press = PRESS_GAP;
+	bool reported = true;
+	bool touched = false;
+	bool was_touched;
+	uint32_t failures;
+	uint32_t n;
+
+	seed = 2463534242UL;
+	electrode_noise = desc->noise;
+	electrode_press = 0;
+	host_electrode = electrode_scan;
+
+	init_onboard_touch_sensor();
+	discard_touch();
+
+	*calibrated = scan_shift();
+	oscillations_scanned = 0;
+
+	for(n = 0; n < SCAN_SAMPLES; n++){
+		if((desc->rise_at != 0) && (n >= desc->rise_at) && (electrode_noise < desc->rise_noise) &&
+			((n - desc->rise_at) % RISE_SAMPLES_PER_COUNT == 0)){
+			electrode_noise++;
+		}
+
+		if(n == next_press){
+			presses++;
+			press_start = n;
+			reported = false;
+			next_press = n + PRESS_SAMPLES + PRESS_GAP + (next_random() % 64);
+		}
+
+		electrode_press = ((press_start != SCAN_SAMPLES) && (n - press_start < PRESS_SAMPLES)) ? (3 * MIN_TOUCH) : 0;
+
+	    /**
+	     * One tick: start the scan, take it as TSI0_IRQHandler() and the main loop would, and sample it
+	     */
+		start_touch_scan();
+		touch_scanned(TOUCH_DATA, 0);
+
+		was_touched = touched;
+		touched = touchpad_is_touched(NULL);
+
+		if(touched && !was_touched){
+			touches++;
+
+			if(reported || (n - press_start > PRESS_REACH)){
+				false_touches++;
+			}
+
+			reported = true;
+		}
+
+		if(!reported && (n - press_start == PRESS_REACH)){
+			missed++;
+			reported = true;
+		}
+	}
+
+	printf("touch_scan,%s,%u,%u,%u.%02u,%u,%u,%u,%u\n",
+		desc->name,
+		*calibrated,
+		scan_shift(),
+		(uint32_t)(oscillations_scanned / SCAN_SAMPLES),
+		(uint32_t)(((oscillations_scanned * 100) / SCAN_SAMPLES) % 100),
+		presses,
+		touches,
+		false_touches,
+		missed);
+
+	failures = false_touches + missed;
+
+    /**
+     * Rising noise has to lengthen the scan
+     */
+	if((desc->rise_at != 0) && (scan_shift() >= *calibrated)){
+		failures++;
+	}
+
+	return (failures);
+}
+
+int main(void)
+{
+	uint32_t failures = 0;
+	uint8_t previous = TOUCH_SCAN_SHIFT_MAX;
+	uint8_t calibrated;
+	uint32_t n;
+
+	for(n = 0; n < sizeof(electrode_descs) / sizeof(electrode_descs[0]); n++){
+		failures += test_electrode(&electrode_descs[n], &calibrated);
+
+	    /**
+	     * The steady electrodes are listed from quietest to noisiest, so their scans may only get
+	     * longer
+	     */
+		if(electrode_descs[n].rise_at == 0){
+			failures += (calibrated > previous);
+			previous = calibrated;
+		}
+
+	    /**
+	     * The quietest electrode has to scan shorter than full length, or nothing adapts
+	     */
+		if(n == 0){
+			failures += (calibrated == 0);
+		}
+	}
+
+	return (failures != 0);
+}
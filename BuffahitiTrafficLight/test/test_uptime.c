@@ -0,0 +1,261 @@
+/**
+ * \file    test_uptime.c
+ * \author	Dayton Flores (dafl2542@colorado.edu)
+ * \date	10/16/2022
+ * \brief   Host tests of the uptime clock in systick.c, run against the SysTick model in
+ * 			host_systick.c. Reads are placed at every phase of a reload, with the SysTick interrupt
+ * 			taken at every point inside them or held off by masking, and run on past the wrap of
+ * 			the 32-bit systick_counts(). Each read has to fall between what the counter had run
+ * 			before and after it, and uptime never goes backwards, including across clock switches.
+ * 			Prints one line per run:
+ * 			uptime,<run>,<reads>,<boundary reads>,<pending reads>,<switches>,<final counts>,<out of range>,<backwards>
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "core_cm0plus.h"
+
+/**
+ * User-defined libraries
+ */
+#include "event.h"
+#include "systick.h"
+
+/**
+ * \def		UPTIME_READS
+ * \brief	Reads per run. Each one is near a reload, so this is past 2^32 counts several times over
+ */
+#define UPTIME_READS\
+	(200000UL)
+
+/**
+ * \def		BOUNDARY_REACH
+ * \brief	Reads near a reload start up to this many clocks either side of it
+ */
+#define BOUNDARY_REACH\
+	(6)
+
+/**
+ * \def		SWITCH_EVERY
+ * \brief	In the switching run, the clock switches on average once every this many reads
+ */
+#define SWITCH_EVERY\
+	(16)
+
+/**
+ * \typedef	uptime_run_t
+ * \brief	To allow objects of struct uptime_run_s to be declared with ease
+ */
+typedef struct uptime_run_s uptime_run_t;
+
+/**
+ * \struct	uptime_run_s
+ * \brief	What one run found
+ */
+struct uptime_run_s {
+	uint32_t boundary_reads;
+	uint32_t pending_reads;
+	uint32_t switches;
+	uint32_t out_of_range;
+	uint32_t backwards;
+};
+
+/**
+ * \var		uint32_t seed
+ * \brief	State of the pseudo-random generator
+ */
+static uint32_t seed = 2463534242UL;
+
+/**
+ * \fn		uint32_t next_random
+ * \param	N/A
+ * \return	The next pseudo-random value
+ * \brief   xorshift32, so every run is reproducible
+ */
+static uint32_t next_random(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return (seed);
+}
+
+/**
+ * \fn		void run_counter
+ * \param	uint32_t clocks Clocks to let the counter run, less 1
+ * \return	N/A
+ * \brief   Let time pass outside of systick.c, taking the interrupt if it comes due
+ */
+static void run_counter(uint32_t clocks)
+{
+    /**
+     * A real interrupt is taken within a few clocks, not a whole period later, so anything
+     * left pending by the last read is taken before the long stretch
+     */
+	host_systick_delay = 0;
+	host_systick_step = 0;
+	(void)SCB;
+
+	host_systick_step = clocks;
+	(void)SCB;
+	host_systick_step = 1;
+	(void)SCB;
+}
+
+/**
+ * \fn		void switch_clock
+ * \param	uint32_t scale SysTick counts per counter clock in the new mode
+ * \return	N/A
+ * \brief   Pause and resume SysTick around a clock switch as idle_run_mode() does, with
+ * 			interrupts masked
+ */
+static void switch_clock(uint32_t scale)
+{
+	host_systick_masked = true;
+	systick_pause();
+	host_systick_scale = scale;
+	(void)systick_resume(scale, 0);
+	host_systick_masked = false;
+}
+
+/**
+ * \fn		void check_read
+ * \param	uint64_t value What uptime_counts() returned
+ * \param	uint64_t before host_systick_elapsed before the read
+ * \param	uint64_t after host_systick_elapsed after the read
+ * \param	uint64_t *last The previous read
+ * \param	uptime_run_t *run Receives any failure
+ * \return	N/A
+ * \brief   One read has to fall between the counter before and after it and follow the last
+ */
+static void check_read(uint64_t value, uint64_t before, uint64_t after, uint64_t *last, uptime_run_t *run)
+{
+	if((value < before) || (value > after)){
+		run->out_of_range++;
+	}
+
+	if(value < *last){
+		run->backwards++;
+	}
+
+	*last = value;
+}
+
+/**
+ * \fn		uint32_t test_run
+ * \param	const char *name Name printed for the run
+ * \param	bool switching True to switch between RUN and VLPR now and then
+ * \return	Number of failures
+ * \brief   Read SysTick UPTIME_READS more times. Without switching, every other
+ * 			read starts within BOUNDARY_REACH clocks of a reload. Every read is one of
+ * 			uptime_counts(), systick_counts() or uptime_usec(), taken with interrupts masked one
+ * 			time in four and with the interrupt taken after a random number of accesses otherwise
+ */
+static uint32_t test_run(const char *name, bool switching)
+{
+	uptime_run_t run = {0};
+	uint64_t last = uptime_counts();
+	uint64_t before;
+	uint64_t after;
+	uint64_t value;
+	uint32_t next_boundary;
+	uint32_t read;
+	event_t event;
+
+	for(read = 0; read < UPTIME_READS; read++){
+
+	    /**
+	     * Without switching the periods are exact, so the counter's own count says where the next
+	     * reload is
+	     */
+		if(!switching && (read % 2 == 0)){
+			next_boundary = SYSTICK_PERIOD_COUNTS - (uint32_t)(host_systick_elapsed % SYSTICK_PERIOD_COUNTS);
+
+			if(next_boundary <= BOUNDARY_REACH + 1){
+				next_boundary += SYSTICK_PERIOD_COUNTS;
+			}
+
+			run_counter(next_boundary - 1 - BOUNDARY_REACH + (next_random() % (2 * BOUNDARY_REACH + 1)));
+			run.boundary_reads++;
+		}
+		else{
+			run_counter(next_random() % (SYSTICK_PERIOD_COUNTS / (2 * host_systick_scale)));
+		}
+
+		if(switching && (next_random() % SWITCH_EVERY == 0)){
+			switch_clock((host_systick_scale == 1) ? SYSTICK_VLPR_SCALE : 1);
+			run.switches++;
+		}
+
+		host_systick_masked = (next_random() % 4 == 0);
+		host_systick_delay = next_random() % 8;
+		host_systick_step = next_random() % 3;
+
+		if(host_systick_masked && (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)){
+			run.pending_reads++;
+		}
+
+		before = host_systick_elapsed;
+
+		switch(read % 3){
+		case 0:
+			value = uptime_counts();
+			break;
+		case 1:
+		    /**
+		     * The low 32 bits, put back on whichever upper bits bring them nearest the counter
+		     */
+			value = systick_counts();
+			value += before & ~0xFFFFFFFFULL;
+
+			if(value + (1ULL << 31) < before){
+				value += 1ULL << 32;
+			}
+			else if((value > before + (1ULL << 31)) && (value >= (1ULL << 32))){
+				value -= 1ULL << 32;
+			}
+			break;
+		default:
+			value = uptime_usec() * COUNTS_PER_USEC;
+			before -= (before > COUNTS_PER_USEC) ? COUNTS_PER_USEC : before;
+			break;
+		}
+
+		after = host_systick_elapsed;
+
+		check_read(value, before, after, &last, &run);
+
+		host_systick_masked = false;
+		host_systick_step = 1;
+
+		while(event_take(&event)){
+		}
+	}
+
+	printf("uptime,%s,%u,%u,%u,%u,%llu,%u,%u\n",
+		name,
+		(uint32_t)UPTIME_READS,
+		run.boundary_reads,
+		run.pending_reads,
+		run.switches,
+		(unsigned long long)uptime_counts(),
+		run.out_of_range,
+		run.backwards);
+
+	return (run.out_of_range + run.backwards);
+}
+
+int main(void)
+{
+	uint32_t failures = 0;
+
+	init_onboard_systick();
+
+	failures += test_run("run", false);
+	failures += test_run("switching", true);
+
+	return (failures != 0);
+}